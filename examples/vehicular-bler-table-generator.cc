@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-sidelink-tabulated-error-model.h"
+#include "ns3/mmwave-lte-mi-error-model.h"
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("VehicularBlerTableGenerator");
+
+using namespace ns3;
+using namespace millicar;
+
+int main (int argc, char *argv[])
+{
+  // This script builds the BLER table used by MmWaveSidelinkTabulatedErrorModel,
+  // starting from the BLER curves of MmWaveLteMiErrorModel.
+  // The table can then be loaded with
+  // --ns3::MmWaveSidelinkTabulatedErrorModel::TableFile=<filename>
+
+  std::string filename = "millicar-bler-table.bin"; // the output file
+  MmWaveSidelinkTabulatedErrorModel::TableSpec spec;
+
+  CommandLine cmd;
+  cmd.AddValue ("filename", "name of the output file", filename);
+  cmd.AddValue ("sinrMinDb", "first SINR value of the table, in dB", spec.sinrMinDb);
+  cmd.AddValue ("sinrStepDb", "SINR step of the table, in dB", spec.sinrStepDb);
+  cmd.AddValue ("numSinr", "number of SINR values", spec.numSinr);
+  cmd.AddValue ("tbSizeMin", "smallest TB size of the table, in bytes", spec.tbSizeMin);
+  cmd.AddValue ("tbSizeStepsPerOctave", "number of TB sizes for each doubling of the TB size", spec.tbSizeStepsPerOctave);
+  cmd.AddValue ("numTbSizes", "number of TB sizes", spec.numTbSizes);
+  cmd.AddValue ("numMcs", "number of MCS values", spec.numMcs);
+  cmd.Parse (argc, argv);
+
+  MmWaveSidelinkTabulatedErrorModel::GenerateTable (filename, spec, mmwave::MmWaveLteMiErrorModel::GetTypeId ());
+
+  std::cout << "BLER table written to " << filename << std::endl;
+
+  return 0;
+}
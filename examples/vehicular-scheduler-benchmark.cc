@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-sidelink-scheduler.h"
+#include "ns3/mmwave-sidelink-tb-size-table.h"
+#include "ns3/mmwave-amc.h"
+#include "ns3/command-line.h"
+#include "ns3/object-factory.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <chrono>
+
+NS_LOG_COMPONENT_DEFINE ("VehicularSchedulerBenchmark");
+
+using namespace ns3;
+using namespace millicar;
+
+int main (int argc, char *argv[])
+{
+  // This script measures the cost of the computations of the TB sizes done
+  // by the sidelink schedulers. It compares the search of the number of
+  // symbols done by mmwave::MmWaveAmc::GetMinNumSymForTbSize with the binary
+  // search over the MmWaveSidelinkTbSizeTable, and then measures the time
+  // needed by a full scheduling decision.
+
+  uint32_t numIterations = 100000; // the number of scheduling decisions
+  uint32_t numLcs = 8; // the number of active logical channels
+  uint32_t subChannelSize = 0; // the number of RBs per sub-channel
+  std::string schedulerType = "ns3::MmWaveSidelinkPfScheduler"; // the scheduler
+
+  CommandLine cmd;
+  cmd.AddValue ("numIterations", "number of scheduling decisions", numIterations);
+  cmd.AddValue ("numLcs", "number of active logical channels", numLcs);
+  cmd.AddValue ("subChannelSize", "number of RBs per sub-channel, 0 to use all the RBs", subChannelSize);
+  cmd.AddValue ("schedulerType", "the TypeId of the scheduler", schedulerType);
+  cmd.Parse (argc, argv);
+
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  Ptr<mmwave::MmWaveAmc> amc = CreateObject<mmwave::MmWaveAmc> (pmc);
+  uint32_t numRb = pmc->GetNumRb ();
+  uint8_t symPerSlot = pmc->GetSymbPerSlot ();
+
+  auto start = std::chrono::steady_clock::now ();
+  Ptr<MmWaveSidelinkTbSizeTable> table = Create<MmWaveSidelinkTbSizeTable> (pmc);
+  auto end = std::chrono::steady_clock::now ();
+  std::cout << "Table built in "
+            << std::chrono::duration<double, std::micro> (end - start).count () << " us" << std::endl;
+
+  // the input of the scheduler, the TB sizes cover from a few bytes to
+  // more than a full slot
+  SlSchedulerParams params;
+  params.availableSymbols = symPerSlot;
+  params.subChannelSize = subChannelSize;
+  for (uint32_t i = 0; i < numLcs; i++)
+  {
+    uint8_t mcs = (i * 7) % MmWaveSidelinkTbSizeTable::NUM_MCS;
+    uint32_t requiredBytes = 50 << (i % 10);
+    params.lcs.push_back (SlSchedulerLcInfo {uint8_t (i + 1), uint16_t (i + 1), mcs, requiredBytes, 0});
+  }
+
+  // compute the number of symbols of each logical channel with the AMC, as
+  // done by the schedulers before the table was introduced. The AMC is not
+  // limited to a slot, hence its output is capped as done by the table
+  uint64_t checksum = 0;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t n = 0; n < numIterations; n++)
+  {
+    for (const auto& lc : params.lcs)
+    {
+      checksum += std::min<int> (amc->GetMinNumSymForTbSize (lc.requiredBytes, lc.mcs), symPerSlot);
+    }
+  }
+  end = std::chrono::steady_clock::now ();
+  double amcTime = std::chrono::duration<double, std::nano> (end - start).count () / numIterations;
+
+  // compute the same values with the table
+  uint64_t tableChecksum = 0;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t n = 0; n < numIterations; n++)
+  {
+    for (const auto& lc : params.lcs)
+    {
+      tableChecksum += table->GetMinNumSym (lc.requiredBytes, lc.mcs, numRb, symPerSlot);
+    }
+  }
+  end = std::chrono::steady_clock::now ();
+  double tableTime = std::chrono::duration<double, std::nano> (end - start).count () / numIterations;
+  NS_ABORT_MSG_IF (checksum != tableChecksum, "The table and the AMC return different numbers of symbols");
+
+  // measure a full scheduling decision
+  ObjectFactory factory;
+  factory.SetTypeId (schedulerType);
+  Ptr<MmWaveSidelinkScheduler> scheduler = factory.Create<MmWaveSidelinkScheduler> ();
+  scheduler->SetConfiguration (pmc, table);
+  uint64_t numGrants = 0;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t n = 0; n < numIterations; n++)
+  {
+    params.timingInfo = mmwave::SfnSf (n / 10, n % 10, 0);
+    numGrants += scheduler->Schedule (params).size ();
+  }
+  end = std::chrono::steady_clock::now ();
+  double scheduleTime = std::chrono::duration<double, std::nano> (end - start).count () / numIterations;
+
+  std::cout << "Symbols of " << numLcs << " logical channels, AMC:\t" << amcTime << " ns per decision" << std::endl;
+  std::cout << "Symbols of " << numLcs << " logical channels, table:\t" << tableTime << " ns per decision" << std::endl;
+  std::cout << "Scheduling decision with " << schedulerType << ":\t" << scheduleTime << " ns ("
+            << double (numGrants) / numIterations << " grants per decision)" << std::endl;
+
+  scheduler->Dispose ();
+  amc->Dispose ();
+  return 0;
+}
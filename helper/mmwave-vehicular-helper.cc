@@ -23,6 +23,10 @@
 #include "ns3/mmwave-vehicular-net-device.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/multi-model-spectrum-channel.h"
+#include "ns3/mmwave-vehicular-spectrum-channel.h"
+#include "ns3/mmwave-sidelink-slot-clock.h"
+#include "ns3/mmwave-sidelink-psd-cache.h"
+#include "ns3/mmwave-sidelink-tb-size-table.h"
 #include "ns3/three-gpp-spectrum-propagation-loss-model.h"
 #include "ns3/three-gpp-v2v-propagation-loss-model.h"
 #include "ns3/three-gpp-v2v-channel-condition-model.h"
@@ -30,6 +34,7 @@
 #include "ns3/mmwave-beamforming-model.h"
 #include "ns3/pointer.h"
 #include "ns3/config.h"
+#include "ns3/boolean.h"
 
 namespace ns3 {
 
@@ -69,6 +74,13 @@ MmWaveVehicularHelper::GetTypeId ()
                  StringValue("V2V-Urban"),
                  MakeStringAccessor (&MmWaveVehicularHelper::SetChannelModelType),
                  MakeStringChecker())
+  .AddAttribute ("SpectrumChannelType",
+                 "The type of SpectrumChannel to be used. "
+                 "Use ns3::MmWaveVehicularSpectrumChannel, together with its "
+                 "MaxInterferenceDistance, to deliver the signals only to the nearby devices",
+                 StringValue ("ns3::MultiModelSpectrumChannel"),
+                 MakeStringAccessor (&MmWaveVehicularHelper::SetSpectrumChannelType),
+                 MakeStringChecker ())
   .AddAttribute ("Numerology",
                  "Numerology to use for the definition of the frame structure."
                  "2 : subcarrier spacing will be set to 60 KHz"
@@ -84,12 +96,21 @@ MmWaveVehicularHelper::GetTypeId ()
   .AddAttribute ("SchedulingPatternOption",
                  "The type of scheduling pattern option to be used for resources assignation."
                  "Default   : one single slot per subframe for each device"
-                 "Optimized : each slot of the subframe is used",
+                 "Optimized : each slot of the subframe is used"
+                 "Sensing   : no pattern, each device selects its slots based on the sensed occupancy",
                  EnumValue(DEFAULT),
                  MakeEnumAccessor (&MmWaveVehicularHelper::SetSchedulingPatternOptionType,
                                    &MmWaveVehicularHelper::GetSchedulingPatternOptionType),
                  MakeEnumChecker(DEFAULT, "Default",
-                                 OPTIMIZED, "Optimized"))
+                                 OPTIMIZED, "Optimized",
+                                 SENSING, "Sensing"))
+  .AddAttribute ("UseSharedSlotClock",
+                 "If true, the slots of all the installed PHYs are started by a "
+                 "single MmWaveSidelinkSlotClock, which schedules one event per slot "
+                 "instead of one event per slot and per device",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MmWaveVehicularHelper::m_useSharedSlotClock),
+                 MakeBooleanChecker ())
   ;
 
   return tid;
@@ -111,12 +132,24 @@ MmWaveVehicularHelper::DoInitialize ()
   }
 
   m_channel = CreateSpectrumChannel (m_channelModelType);
+
+  // create the transmit PSD cache shared by the PHYs
+  m_psdCache = Create<MmWaveSidelinkPsdCache> (m_phyMacConfig);
+
+  // create the TB size table shared by the MACs
+  m_tbSizeTable = Create<MmWaveSidelinkTbSizeTable> (m_phyMacConfig);
+
+  // create the slot clock shared by the PHYs
+  if (m_useSharedSlotClock)
+  {
+    m_slotClock = CreateObject<MmWaveSidelinkSlotClock> (m_phyMacConfig);
+  }
 }
 
 Ptr<SpectrumChannel>
 MmWaveVehicularHelper::CreateSpectrumChannel (std::string channelModelType) const
 {  
-  Ptr<SpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel> ();
+  Ptr<SpectrumChannel> channel = m_channelFactory.Create<SpectrumChannel> ();
   if (channelModelType == "V2V-Urban")
   {
     Ptr<ChannelConditionModel> ccm = CreateObject<ThreeGppV2vUrbanChannelConditionModel> ();
@@ -164,6 +197,23 @@ MmWaveVehicularHelper::SetConfigurationParameters (Ptr<mmwave::MmWavePhyMacCommo
   NS_LOG_FUNCTION (this);
   NS_ASSERT_MSG (m_rntiCounter == 0, "The PHY configuration should be set before the installation of any device.");
   m_phyMacConfig = conf;
+
+  // the cached PSDs, the TB sizes and the slot timing depend on the
+  // configuration parameters
+  if (m_psdCache)
+  {
+    m_psdCache = Create<MmWaveSidelinkPsdCache> (m_phyMacConfig);
+  }
+  if (m_tbSizeTable)
+  {
+    m_tbSizeTable = Create<MmWaveSidelinkTbSizeTable> (m_phyMacConfig);
+  }
+  if (m_slotClock)
+  {
+    // cancel the first tick of the old clock, which has no PHYs yet
+    m_slotClock->Dispose ();
+    m_slotClock = CreateObject<MmWaveSidelinkSlotClock> (m_phyMacConfig);
+  }
 }
 
 Ptr<mmwave::MmWavePhyMacCommon>
@@ -187,6 +237,13 @@ MmWaveVehicularHelper::SetChannelModelType (std::string model)
   m_channelModelType = model;
 }
 
+void
+MmWaveVehicularHelper::SetSpectrumChannelType (std::string type)
+{
+  NS_LOG_FUNCTION (this << type);
+  m_channelFactory = ObjectFactory (type);
+}
+
 NetDeviceContainer
 MmWaveVehicularHelper::InstallMmWaveVehicularNetDevices (NodeContainer nodes)
 {
@@ -230,6 +287,11 @@ MmWaveVehicularHelper::InstallSingleMmWaveVehicularNetDevice (Ptr<Node> node, ui
   // create the phy
   NS_ASSERT_MSG (m_phyMacConfig, "First set the configuration parameters");
   Ptr<MmWaveSidelinkPhy> phy = CreateObject<MmWaveSidelinkPhy> (ssp, m_phyMacConfig);
+  phy->SetPsdCache (m_psdCache);
+  if (m_slotClock)
+  {
+    m_slotClock->AddPhy (phy);
+  }
 
   // add the spectrum phy to the spectrum channel
   m_channel->AddRx (ssp);
@@ -248,12 +310,13 @@ MmWaveVehicularHelper::InstallSingleMmWaveVehicularNetDevice (Ptr<Node> node, ui
 
   if(m_phyTraceHelper)
   {
-    ssp->SetSidelinkSinrReportCallback (MakeCallback (&MmWaveVehicularTracesHelper::McsSinrCallback, m_phyTraceHelper));
+    ssp->TraceConnectWithoutContext ("SlSinrReport", MakeCallback (&MmWaveVehicularTracesHelper::McsSinrCallback, m_phyTraceHelper));
   }
 
   // create the mac
   Ptr<MmWaveSidelinkMac> mac = CreateObject<MmWaveSidelinkMac> (m_phyMacConfig);
   mac->SetRnti (rnti);
+  mac->SetTbSizeTable (m_tbSizeTable);
 
   // connect phy and mac
   phy->SetPhySapUser (mac->GetPhySapUser ());
@@ -277,6 +340,22 @@ MmWaveVehicularHelper::InstallSingleMmWaveVehicularNetDevice (Ptr<Node> node, ui
   bfModel->SetAttributeFailSafe ("Antenna", PointerValue (aam));
   bfModel->SetAttributeFailSafe ("ChannelModel", PointerValue (channelModel));
   ssp->SetBeamformingModel (bfModel);
+
+  // if requested, reuse the beamforming vectors for the UpdatePeriod of the
+  // channel model. With an UpdatePeriod of 0 the channel is regenerated
+  // only when the LOS condition changes, which the cache can not detect,
+  // hence the cache is disabled
+  TimeValue beamCacheValidity;
+  ssp->GetAttribute ("BeamCacheValidity", beamCacheValidity);
+  if (beamCacheValidity.Get ().IsStrictlyNegative ())
+  {
+    TimeValue updatePeriod (Seconds (0));
+    if (channelModel)
+    {
+      channelModel->GetAttributeFailSafe ("UpdatePeriod", updatePeriod);
+    }
+    ssp->SetAttribute ("BeamCacheValidity", updatePeriod);
+  }
   
   return device;
 }
@@ -289,7 +368,13 @@ MmWaveVehicularHelper::PairDevices (NetDeviceContainer devices)
   // TODO update this part to enable a more flexible configuration of the
   // scheduling pattern
 
-  std::vector<uint16_t> pattern = CreateSchedulingPattern(devices);
+  // with the sensing-based selection there is no pattern, hence the size of
+  // the group is not limited by the number of slots
+  std::vector<uint16_t> pattern;
+  if (m_schedulingOpt != SENSING)
+  {
+    pattern = CreateSchedulingPattern(devices);
+  }
 
   uint8_t bearerId = 1;
 
@@ -301,7 +386,19 @@ MmWaveVehicularHelper::PairDevices (NetDeviceContainer devices)
       Ptr<Ipv4> iNodeIpv4 = iNode->GetObject<Ipv4> ();
       NS_ASSERT_MSG (iNodeIpv4, "Nodes need to have IPv4 installed before pairing can be activated");
 
-      di->GetMac ()->SetSfAllocationInfo (pattern); // this is called ONCE for each NetDevice
+      if (m_schedulingOpt == SENSING)
+      {
+        di->GetMac ()->SetAttribute ("ResourceSelectionMode", EnumValue (MmWaveSidelinkMac::SENSING_BASED));
+
+        // connect the callback to report the sensed signals, which is not
+        // needed with a static pattern
+        Ptr<MmWaveSidelinkPhy> phy = di->GetPhy ();
+        phy->GetSpectrumPhy ()->SetSidelinkSensingCallback (MakeCallback (&MmWaveSidelinkPhy::GenerateSensingReport, phy));
+      }
+      else
+      {
+        di->GetMac ()->SetSfAllocationInfo (pattern); // this is called ONCE for each NetDevice
+      }
 
       for (NetDeviceContainer::Iterator j = i + 1; j != devices.End (); ++j)
       {
@@ -33,6 +33,9 @@ namespace ns3 {
 namespace millicar {
 
 class MmWaveVehicularNetDevice;
+class MmWaveSidelinkSlotClock;
+class MmWaveSidelinkPsdCache;
+class MmWaveSidelinkTbSizeTable;
 
 /**
  * This class is used for the creation of MmWaveVehicularNetDevices and
@@ -98,6 +101,12 @@ public:
    */
   void SetChannelModelType (std::string model);
 
+  /**
+   * Configure the type of SpectrumChannel to be used
+   * \param type the type id of the SpectrumChannel
+   */
+  void SetSpectrumChannelType (std::string type);
+
   /**
    * Configure the scheduling pattern for a specific group of devices
    * \param devices the NetDeviceContainer with the devices
@@ -109,7 +118,8 @@ public:
    * Identifies the supported scheduling pattern policies
    */
   enum SchedulingPatternOption_t {DEFAULT = 1,
-                                   OPTIMIZED = 2};
+                                   OPTIMIZED = 2,
+                                   SENSING = 3};
 
   /**
   * Set the scheduling pattern option type
@@ -152,7 +162,12 @@ private:
   SchedulingPatternOption_t m_schedulingOpt; //!< the type of scheduling pattern policy to be adopted
   
   ObjectFactory m_bfModelFactory; //!< beamforming model object factory
+  ObjectFactory m_channelFactory; //!< spectrum channel object factory
   Ptr<MmWaveVehicularTracesHelper> m_phyTraceHelper; //!< Ptr to an helper for the physical layer traces
+  bool m_useSharedSlotClock; //!< if true, the slots of all the PHYs are started by a single MmWaveSidelinkSlotClock
+  Ptr<MmWaveSidelinkSlotClock> m_slotClock; //!< the slot clock shared by the PHYs
+  Ptr<MmWaveSidelinkPsdCache> m_psdCache; //!< the transmit PSD cache shared by the PHYs
+  Ptr<MmWaveSidelinkTbSizeTable> m_tbSizeTable; //!< the TB size table shared by the MACs
 
 };
 
@@ -50,10 +50,9 @@ MmWaveVehicularTracesHelper::~MmWaveVehicularTracesHelper ()
 }
 
 void
-MmWaveVehicularTracesHelper::McsSinrCallback(const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize, uint8_t mcs)
+MmWaveVehicularTracesHelper::McsSinrCallback(const SlSinrReportInfo& report)
 {
-  double sinrAvg = Sum (sinr) / (sinr.GetSpectrumModel ()->GetNumBands ());
-  m_outputFile << Simulator::Now().GetSeconds() << "\t" << rnti << "\t" << 10 * std::log10 (sinrAvg) << "\t" << (uint32_t)numSym << "\t" << tbSize << "\t" << (uint32_t)mcs << std::endl;
+  m_outputFile << Simulator::Now().GetSeconds() << "\t" << report.rnti << "\t" << report.sinr.meanDb << "\t" << (uint32_t)report.numSym << "\t" << report.tbSize << "\t" << (uint32_t)report.mcs << std::endl;
 }
 
 }
@@ -24,6 +24,7 @@
 #include <string>
 #include <ns3/object.h>
 #include <ns3/spectrum-value.h>
+#include <ns3/mmwave-sidelink-sap.h>
 
 namespace ns3 {
 
@@ -48,16 +49,11 @@ public:
   virtual ~MmWaveVehicularTracesHelper();
 
   /**
-   * Method to be attached to the callback in the MmWaveSidelinkSpectrumPhy
-   * \param sinr pointer to the SpectrumValue instance representing the SINR
-            measured on all the spectrum chunks
-   * \param rnti the RNTI of the tranmitting device
-   * \param numSym size of the transport block that generated the report in
-            number of OFDM symbols
-   * \param tbSize size of the transport block that generated the report in bytes
-   * \param mcs the MCS of the transmission
+   * Method to be connected to the SlSinrReport trace source of the
+   * MmWaveSidelinkSpectrumPhy
+   * \param report information about the received transport block
    */
-  void McsSinrCallback(const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize, uint8_t mcs);
+  void McsSinrCallback(const SlSinrReportInfo& report);
 
 private:
   std::string m_filename; //!< filename for the output
@@ -25,6 +25,14 @@
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
 #include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/enum.h"
+#include "ns3/simulator.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 namespace ns3 {
 
@@ -32,6 +40,12 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkMac");
 
 namespace millicar {
 
+// HARQ process ID of the transport blocks sent without HARQ
+static const uint8_t SL_NO_HARQ_PROCESS = 255;
+
+// peer index of the RNTIs which are not peers of the device
+static const uint32_t SL_NO_PEER = std::numeric_limits<uint32_t>::max ();
+
 MacSidelinkMemberPhySapUser::MacSidelinkMemberPhySapUser (Ptr<MmWaveSidelinkMac> mac)
   : m_mac (mac)
 {
@@ -51,9 +65,27 @@ MacSidelinkMemberPhySapUser::SlotIndication (mmwave::SfnSf timingInfo)
 }
 
 void
-MacSidelinkMemberPhySapUser::SlSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize)
+MacSidelinkMemberPhySapUser::SlSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report)
+{
+  m_mac->DoSlSinrReport (sinr, report);
+}
+
+uint32_t
+MacSidelinkMemberPhySapUser::GetSlotsUntilNextActivity (mmwave::SfnSf timingInfo)
+{
+  return m_mac->DoGetSlotsUntilNextActivity (timingInfo);
+}
+
+void
+MacSidelinkMemberPhySapUser::ReceiveFeedback (SlFeedbackInfo feedback)
 {
-  m_mac->DoSlSinrReport (sinr, rnti, numSym, tbSize);
+  m_mac->DoReceiveFeedback (feedback);
+}
+
+void
+MacSidelinkMemberPhySapUser::SlSensingReport (mmwave::SfnSf timingInfo, uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm)
+{
+  m_mac->DoSlSensingReport (timingInfo, senderRnti, destinationRnti, rssiDbm);
 }
 
 //-----------------------------------------------------------------------
@@ -95,10 +127,218 @@ MmWaveSidelinkMac::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&MmWaveSidelinkMac::m_useAmc),
                    MakeBooleanChecker ())
+    .AddAttribute ("CqiHistorySize",
+                   "Number of CQIs kept for each device.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_cqiHistorySize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CqiFilterWeight",
+                   "Weight of the latest CQI in the exponential moving average used to "
+                   "select the MCS. If 1, the MCS is selected using only the latest CQI.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_cqiFilterWeight),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CqiExpirationTime",
+                   "Age after which the CQI of a device is considered stale, and the "
+                   "FallbackMcs is used. If 0, the CQI never expires.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MmWaveSidelinkMac::m_cqiExpirationTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("FallbackMcs",
+                   "MCS used with AMC when the CQI of the device is not available or "
+                   "has expired.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_fallbackMcs),
+                   MakeUintegerChecker<uint8_t> (0, 28))
+    .AddAttribute ("OuterLoopLinkAdaptation",
+                   "Set to true to use the outer loop link adaptation. The receivers feed "
+                   "back the outcome of the decoding of each transport block, and the SINR "
+                   "used to select the MCS towards each device is reduced by an offset "
+                   "which is adjusted to reach the TargetBler. It has to be enabled in all "
+                   "the devices.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MmWaveSidelinkMac::m_olla),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TargetBler",
+                   "The BLER targeted by the outer loop link adaptation.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_targetBler),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("OllaStepUp",
+                   "Increase of the SINR offset after a failed transport block in dB. "
+                   "After a successful one, the offset is decreased by "
+                   "OllaStepUp * TargetBler / (1 - TargetBler).",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_ollaStepUp),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("OllaMaxOffset",
+                   "Maximum absolute value of the SINR offset in dB.",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_ollaMaxOffset),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Harq",
+                   "Set to true to use HARQ. The receivers feed back an ACK or a NACK for "
+                   "each transport block, and the failed ones are retransmitted at the "
+                   "beginning of the next slot assigned to the device. The receiver "
+                   "combines the retransmissions with the previous copies of the transport "
+                   "block. A transport block without feedback after two slots is considered "
+                   "lost. It has to be enabled in all the devices.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MmWaveSidelinkMac::m_harq),
+                   MakeBooleanChecker ())
+    .AddAttribute ("NumHarqProcesses",
+                   "Number of HARQ processes for each destination. New transport blocks "
+                   "are not scheduled towards a destination whose processes are all active.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_numHarqProcesses),
+                   MakeUintegerChecker<uint8_t> (1, SL_NO_HARQ_PROCESS - 1))
+    .AddAttribute ("MaxHarqRetransmissions",
+                   "Maximum number of retransmissions of a transport block, after which "
+                   "it is discarded.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_maxHarqRetx),
+                   MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("SubChannelSize",
+                   "Number of RBs in each sub-channel. If larger than 0, the available "
+                   "RBs are split in sub-channels, which are assigned to different logical "
+                   "channels in the same symbols. If 0, each transport block uses all the RBs.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_subChannelSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("TxPowerControl",
+                   "Set to true to use the closed-loop power control. The receivers feed "
+                   "back the SINR of each transport block, and the tx power towards each "
+                   "device is adjusted to reach the TargetSinr. It has to be enabled in "
+                   "all the devices.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MmWaveSidelinkMac::m_txPowerControl),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TargetSinr",
+                   "The SINR targeted by the power control in dB.",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_targetSinr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MinTxPower",
+                   "The minimum tx power selected by the power control in dBm.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_minTxPower),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxTxPower",
+                   "The maximum tx power selected by the power control in dBm. It is "
+                   "also used towards the devices which did not send any feedback yet.",
+                   DoubleValue (30.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_maxTxPower),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("TxPowerStep",
+                   "The step used by the power control to update the tx power in dB.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_txPowerStep),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("ResourceSelectionMode",
+                   "How the slots used by the device are selected. With StaticPattern, "
+                   "the slots are assigned by the pattern set with SetSfAllocationInfo. "
+                   "With Sensing, the device senses the power received in each slot, "
+                   "excludes the busy ones and reserves NumReservedSlots slots in each "
+                   "subframe, for a number of subframes given by the reselection counter. "
+                   "A device expects the transmissions of another device in the slots in "
+                   "which it received from it in the previous subframes. The sensing "
+                   "reports are generated only if the PHY sensing callback is connected, "
+                   "which MmWaveVehicularHelper does with the Sensing scheduling pattern option.",
+                   EnumValue (STATIC_PATTERN),
+                   MakeEnumAccessor (&MmWaveSidelinkMac::m_resourceSelection),
+                   MakeEnumChecker (STATIC_PATTERN, "StaticPattern",
+                                    SENSING_BASED, "Sensing"))
+    .AddAttribute ("SensingWindow",
+                   "Time over which the sensed power is considered to select the slots.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&MmWaveSidelinkMac::m_sensingWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("SensingThreshold",
+                   "Received power above which a slot is considered busy in dBm.",
+                   DoubleValue (-90.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_sensingThreshold),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MinCandidateRatio",
+                   "Minimum fraction of the slots which must be left as candidates "
+                   "after the exclusion of the busy ones. If less slots are left, the "
+                   "SensingThreshold is increased by 3 dB until the ratio is reached.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_minCandidateRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("NumReservedSlots",
+                   "Number of slots reserved in each subframe with the sensing-based "
+                   "resource selection.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_numReservedSlots),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MinReselectionCounter",
+                   "Minimum number of subframes for which the selected slots are reserved.",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_minReselectionCounter),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxReselectionCounter",
+                   "Maximum number of subframes for which the selected slots are reserved.",
+                   UintegerValue (15),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_maxReselectionCounter),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ProbResourceKeep",
+                   "Probability of keeping the reserved slots when the reselection "
+                   "counter expires.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkMac::m_probResourceKeep),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("TxQueueCapacity",
+                   "Initial number of PDUs which can be stored in the tx queue of each "
+                   "destination. The queue is allocated when the destination is paired "
+                   "and its capacity is doubled when it is full.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::m_txQueueCapacity),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TxQueueBytes",
+                   "Number of bytes stored in the tx queues of all the destinations.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::GetTxQueueBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("TxQueuePackets",
+                   "Number of PDUs stored in the tx queues of all the destinations.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkMac::GetTxQueuePackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SchedulerType",
+                   "The type of scheduler used to share the slots assigned to the device "
+                   "among its logical channels. It must be a subclass of "
+                   "MmWaveSidelinkScheduler.",
+                   TypeIdValue (MmWaveSidelinkRrScheduler::GetTypeId ()),
+                   MakeTypeIdAccessor (&MmWaveSidelinkMac::SetSchedulerType,
+                                       &MmWaveSidelinkMac::GetSchedulerType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("Scheduler",
+                   "The scheduler used to share the slots assigned to the device among "
+                   "its logical channels.",
+                   TypeId::ATTR_GET,
+                   PointerValue (),
+                   MakePointerAccessor (&MmWaveSidelinkMac::m_scheduler),
+                   MakePointerChecker<MmWaveSidelinkScheduler> ())
     .AddTraceSource ("SchedulingInfo",
-                     "Information regarding the scheduling.",
+                     "Information regarding the scheduling. It is fired once per grant, "
+                     "hence the grants of different logical channels merged in a single "
+                     "transport block are reported separately.",
                      MakeTraceSourceAccessor (&MmWaveSidelinkMac::m_schedulingTrace),
                      "ns3::millicar::MmWaveSidelinkMac::SlSchedulingTracedCallback")
+    .AddTraceSource ("TxPower",
+                     "The tx power selected by the power control.",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkMac::m_txPowerTrace),
+                     "ns3::millicar::MmWaveSidelinkMac::TxPowerTracedCallback")
+    .AddTraceSource ("SinrOffset",
+                     "The SINR offset of the outer loop link adaptation.",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkMac::m_sinrOffsetTrace),
+                     "ns3::millicar::MmWaveSidelinkMac::SinrOffsetTracedCallback")
+    .AddTraceSource ("ResourceSelection",
+                     "The slots selected by the sensing-based resource selection.",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkMac::m_resourceSelectionTrace),
+                     "ns3::millicar::MmWaveSidelinkMac::ResourceSelectionTracedCallback")
   ;
   return tid;
 }
@@ -124,6 +364,15 @@ MmWaveSidelinkMac::MmWaveSidelinkMac (Ptr<mmwave::MmWavePhyMacCommon> pmc)
   // initialize the scheduling patter
   std::vector<uint16_t> pattern (m_phyMacConfig->GetSlotsPerSubframe (), 0);
   m_sfAllocInfo = pattern;
+
+  // initialize the state of the sensing-based resource selection
+  m_sensedSlotOwner = std::vector<std::pair<uint16_t, Time>> (m_phyMacConfig->GetSlotsPerSubframe (), std::make_pair (0, Time ()));
+  m_reselectionCounter = 0;
+  m_uniformRv = CreateObject<UniformRandomVariable> ();
+
+  // the tx queues are created when the peers are added
+  m_txQueueBytes = 0;
+  m_txQueuePackets = 0;
 }
 
 MmWaveSidelinkMac::~MmWaveSidelinkMac (void)
@@ -136,6 +385,16 @@ MmWaveSidelinkMac::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   delete m_phySapUser;
+  if (m_scheduler)
+  {
+    m_scheduler->Dispose ();
+    m_scheduler = nullptr;
+  }
+  m_tbSizeTable = nullptr;
+  m_harqProcesses.clear ();
+  m_harqRetxQueue.clear ();
+  m_txQueues.clear ();
+  m_peerIndexMap.clear ();
   Object::DoDispose ();
 }
 
@@ -146,33 +405,73 @@ MmWaveSidelinkMac::DoSlotIndication (mmwave::SfnSf timingInfo)
 
   NS_ASSERT_MSG (m_rnti != 0, "First set the RNTI");
   NS_ASSERT_MSG (!m_sfAllocInfo.empty (), "First set the scheduling pattern");
-  if(m_sfAllocInfo [timingInfo.m_slotNum] == m_rnti) // check if this slot is associated to the user who required it
+
+  if (m_resourceSelection == SENSING_BASED)
   {
-    mmwave::SlotAllocInfo allocationInfo = ScheduleResources (timingInfo);
+    UpdateReservation (timingInfo);
+  }
+
+  uint16_t slotOwner = GetSlotOwner (timingInfo);
+  if(slotOwner == m_rnti) // check if this slot is associated to the user who required it
+  {
+    // the reservation lasts for a given number of subframes
+    if (m_resourceSelection == SENSING_BASED && timingInfo.m_slotNum == m_reservedSlots.front ())
+    {
+      m_reselectionCounter--;
+    }
+
+    // the retransmissions are sent first, the new transport blocks use the
+    // remaining symbols
+    uint8_t firstSymbol = 0;
+    if (m_harq)
+    {
+      firstSymbol = ScheduleHarqRetransmissions (timingInfo);
+    }
+    std::vector<SlTtiAllocInfo> allocationInfo = ScheduleResources (timingInfo, firstSymbol);
 
     // associate slot alloc info and pdu
-    for (auto it = allocationInfo.m_ttiAllocInfo.begin(); it != allocationInfo.m_ttiAllocInfo.end (); it++)
+    for (auto it = allocationInfo.begin(); it != allocationInfo.end (); it++)
     {
-      // retrieve the tx buffer corresponding to the assigned destination
-      auto txBuffer = m_txBufferMap.find (it->m_rnti); // the destination RNTI
+      // retrieve the tx queue corresponding to the assigned destination
+      SlTxQueue* txQueue = GetTxQueue (it->m_rnti); // the destination RNTI
 
-      if (txBuffer == m_txBufferMap.end () || txBuffer->second.empty ())
+      if (txQueue == nullptr || txQueue->pdus.IsEmpty ())
       {
         // discard the tranmission opportunity and go to the next transmission
         continue;
       }
 
-      // otherwise, forward the packet to the PHY
+      // otherwise, fill the transport block with the PDUs for this
+      // destination, as long as they fit. The first PDU is always sent.
+      // The receiver delivers each PDU to the proper RLC instance using its
+      // LteRadioBearerTag.
       Ptr<PacketBurst> pb = CreateObject<PacketBurst> ();
-      pb->AddPacket (txBuffer->second.front ().pdu);
+      uint32_t tbBytes = 0;
+      do
+      {
+        Ptr<Packet> pdu = txQueue->pdus.Front ().pdu;
+        tbBytes += pdu->GetSize ();
+        pb->AddPacket (pdu);
+        txQueue->pdus.PopFront ();
+        txQueue->bytes -= pdu->GetSize ();
+        m_txQueueBytes -= pdu->GetSize ();
+        m_txQueuePackets--;
+      }
+      while (!txQueue->pdus.IsEmpty () &&
+             tbBytes + txQueue->pdus.Front ().pdu->GetSize () <= it->m_dci.m_tbSize);
+
+      NS_LOG_DEBUG ("TB for rnti " << it->m_rnti << " carries " << pb->GetNPackets () << " PDUs, " << tbBytes << " bytes");
+      if (m_harq)
+      {
+        StartHarqProcess (pb, *it);
+      }
       m_phySapProvider->AddTransportBlock (pb, *it);
-      txBuffer->second.pop_front ();
     }
   }
-  else if (m_sfAllocInfo[timingInfo.m_slotNum] != 0) // if the slot is assigned to another device, prepare for reception
+  else if (slotOwner != 0) // if the slot is assigned to another device, prepare for reception
   {
-    NS_LOG_INFO ("Prepare for reception from rnti " << m_sfAllocInfo[timingInfo.m_slotNum]);
-    m_phySapProvider->PrepareForReception (m_sfAllocInfo[timingInfo.m_slotNum]);
+    NS_LOG_INFO ("Prepare for reception from rnti " << slotOwner);
+    m_phySapProvider->PrepareForReception (slotOwner);
   }
   else // the slot is not assigned to any user
   {
@@ -181,131 +480,263 @@ MmWaveSidelinkMac::DoSlotIndication (mmwave::SfnSf timingInfo)
 
 }
 
-mmwave::SlotAllocInfo
-MmWaveSidelinkMac::ScheduleResources (mmwave::SfnSf timingInfo)
+uint16_t
+MmWaveSidelinkMac::GetSlotOwner (mmwave::SfnSf timingInfo) const
 {
-  mmwave::SlotAllocInfo allocationInfo; // stores all the allocation decisions
-  allocationInfo.m_sfnSf = timingInfo;
-  allocationInfo.m_numSymAlloc = 0;
-
-  NS_LOG_DEBUG("m_bufferStatusReportMap.size () =\t" << m_bufferStatusReportMap.size ());
-  // if there are no active channels return an empty vector
-  if (m_bufferStatusReportMap.size () == 0)
+  if (m_resourceSelection == STATIC_PATTERN)
   {
-    return allocationInfo;
+    return m_sfAllocInfo [timingInfo.m_slotNum];
   }
 
-  // compute the total number of available symbols
-  uint32_t availableSymbols = m_phyMacConfig->GetSymbPerSlot ();
-
-  NS_LOG_DEBUG("availableSymbols =\t" << availableSymbols);
-
-  // compute the number of available symbols per logical channel
-  // NOTE the number of available symbols per LC is rounded down due to the cast
-  // to int
-  uint32_t availableSymbolsPerLc = availableSymbols / m_bufferStatusReportMap.size ();
-
-  NS_LOG_DEBUG("availableSymbolsPerLc =\t" << availableSymbolsPerLc);
-
-  // TODO start from the last served lc + 1
-  auto bsrIt = m_bufferStatusReportMap.begin ();
+  if (std::binary_search (m_reservedSlots.begin (), m_reservedSlots.end (), timingInfo.m_slotNum))
+  {
+    return m_rnti;
+  }
 
-  uint8_t symStart = 0; // indicates the next available symbol in the slot
+  // a device which recently transmitted to this one in the same slot is
+  // expected to keep its reservation
+  const std::pair<uint16_t, Time>& owner = m_sensedSlotOwner [timingInfo.m_slotNum];
+  if (owner.first != 0 && Simulator::Now () - owner.second <= m_sensingWindow)
+  {
+    return owner.first;
+  }
+  return 0;
+}
 
-  // serve the active logical channels with a Round Robin approach
-  while (availableSymbols > 0 && m_bufferStatusReportMap.size () > 0)
+void
+MmWaveSidelinkMac::UpdateReservation (mmwave::SfnSf timingInfo)
+{
+  if (!m_reservedSlots.empty () && m_reselectionCounter > 0)
   {
-    uint16_t rntiDest = bsrIt->second.rnti; // the RNTI of the destination node
+    return;
+  }
 
-    uint8_t mcs = GetMcs (rntiDest); // select the MCS
+  // release the reservation if there is nothing to transmit, a new one will
+  // be selected when new data arrives
+  if (!HasPendingData ())
+  {
+    if (!m_reservedSlots.empty ())
+    {
+      NS_LOG_DEBUG ("Release the reserved slots");
+      m_reservedSlots.clear ();
+    }
+    return;
+  }
 
-    NS_LOG_DEBUG("rnti " << rntiDest << " mcs = " << uint16_t(mcs));
-    // compute the number of bits for this LC
-    uint32_t availableBytesPerLc = m_amc->CalculateTbSize(mcs, availableSymbolsPerLc);
+  NS_ABORT_MSG_IF (m_minReselectionCounter > m_maxReselectionCounter, "MinReselectionCounter must not exceed MaxReselectionCounter");
+  if (m_reservedSlots.empty () || m_uniformRv->GetValue () >= m_probResourceKeep)
+  {
+    m_reservedSlots = SelectResources ();
+    for (uint8_t slotNum : m_reservedSlots)
+    {
+      NS_LOG_DEBUG ("Frame " << timingInfo.m_frameNum << " subframe " << uint16_t (timingInfo.m_sfNum) << ": reserve slot " << uint16_t (slotNum));
+      m_resourceSelectionTrace (m_rnti, slotNum);
+    }
+  }
+  m_reselectionCounter = m_uniformRv->GetInteger (m_minReselectionCounter, m_maxReselectionCounter);
+}
 
-    // compute the number of bits required by this LC
-    uint32_t requiredBytes = (bsrIt->second.txQueueSize + bsrIt->second.retxQueueSize + bsrIt->second.statusPduSize);
+std::vector<uint8_t>
+MmWaveSidelinkMac::SelectResources ()
+{
+  // maximum power sensed in each slot over the sensing window
+  uint32_t numSlots = m_phyMacConfig->GetSlotsPerSubframe ();
+  std::vector<double> maxRssi (numSlots, -std::numeric_limits<double>::infinity ());
+  for (const SlSensingRecord& record : m_sensingRecords)
+  {
+    if (Simulator::Now () - record.time <= m_sensingWindow)
+    {
+      maxRssi [record.slotNum] = std::max (maxRssi [record.slotNum], record.rssiDbm);
+    }
+  }
 
-    // assign a number of bits which is less or equal to the available bits
-    uint32_t assignedBytes = 0;
-    if (requiredBytes <= availableBytesPerLc)
+  // exclude the busy slots, relaxing the threshold until enough candidates
+  // are left. The loop ends since the sensed power is finite
+  uint32_t numReserved = std::min (m_numReservedSlots, numSlots);
+  uint32_t minCandidates = std::max<uint32_t> (numReserved, std::ceil (m_minCandidateRatio * numSlots));
+  minCandidates = std::min (minCandidates, numSlots);
+  std::vector<uint8_t> candidates;
+  double threshold = m_sensingThreshold;
+  while (true)
+  {
+    candidates.clear ();
+    for (uint32_t slotNum = 0; slotNum < numSlots; slotNum++)
     {
-      assignedBytes = requiredBytes;
+      if (maxRssi [slotNum] <= threshold)
+      {
+        candidates.push_back (slotNum);
+      }
     }
-    else
+    if (candidates.size () >= minCandidates)
     {
-      assignedBytes = availableBytesPerLc;
+      break;
     }
+    threshold += 3.0;
+  }
+  NS_LOG_DEBUG (candidates.size () << " candidate slots with threshold " << threshold << " dBm");
+
+  // pick the slots at random among the candidates
+  for (uint32_t i = 0; i < numReserved; i++)
+  {
+    uint32_t j = m_uniformRv->GetInteger (i, candidates.size () - 1);
+    std::swap (candidates [i], candidates [j]);
+  }
+  candidates.resize (numReserved);
+  std::sort (candidates.begin (), candidates.end ());
+  return candidates;
+}
+
+std::vector<SlTtiAllocInfo>
+MmWaveSidelinkMac::ScheduleResources (mmwave::SfnSf timingInfo, uint8_t firstSymbol)
+{
+  std::vector<SlTtiAllocInfo> allocationInfo; // stores all the allocation decisions
+
+  NS_LOG_DEBUG("m_bufferStatusReportMap.size () =\t" << m_bufferStatusReportMap.size ());
+  // if there are no active channels or no free symbols return an empty vector
+  if (m_bufferStatusReportMap.size () == 0 || firstSymbol >= m_phyMacConfig->GetSymbPerSlot ())
+  {
+    return allocationInfo;
+  }
 
-    // compute the number of symbols assigned to this LC
-    uint32_t assignedSymbols = m_amc->GetMinNumSymForTbSize (assignedBytes, mcs);
-
-    //if (assignedSymbols <= availableSymbols) // TODO check if needed
-    //{
-    // create the TtiAllocInfo object
-    mmwave::TtiAllocInfo info;
-    info.m_ttiIdx = timingInfo.m_slotNum; // the TB will be sent in this slot
-    info.m_rnti = rntiDest; // the RNTI of the destination node
-    info.m_dci.m_rnti = m_rnti; // my RNTI
-    info.m_dci.m_numSym = assignedSymbols; // the number of symbols required to tx the packet
-    info.m_dci.m_symStart = symStart; // index of the first available symbol
-    info.m_dci.m_mcs = mcs;
-    info.m_dci.m_tbSize = assignedBytes; // the TB size in bytes
-    info.m_ttiType = mmwave::TtiAllocInfo::TddTtiType::DATA; // the TB carries data
-
-    NS_LOG_DEBUG("info.m_dci.m_tbSize =\t" << info.m_dci.m_tbSize);
-
-    allocationInfo.m_ttiAllocInfo.push_back (info);
-    allocationInfo.m_numSymAlloc += assignedSymbols;
-
-    // fire the scheduling trace
-    SlSchedulingCallback traceInfo;
-    traceInfo.frame = timingInfo.m_frameNum;
-    traceInfo.subframe = timingInfo.m_sfNum;
-    traceInfo.slotNum = timingInfo.m_slotNum;
-    traceInfo.symStart = symStart;
-    traceInfo.numSym = assignedSymbols;
-    traceInfo.mcs = mcs;
-    traceInfo.tbSize = assignedBytes;
-    traceInfo.txRnti = m_rnti;
-    traceInfo.rxRnti = rntiDest;
-    m_schedulingTrace (traceInfo);
-
-    // notify the RLC
-    LteMacSapUser* macSapUser = m_lcidToMacSap.find (bsrIt->second.lcid)->second;
-    LteMacSapUser::TxOpportunityParameters params;
-    params.bytes = assignedBytes;  // the number of bytes to transmit
-    params.layer = 0;  // the layer of transmission (MIMO) (NOT USED)
-    params.harqId = 0; // the HARQ ID (NOT USED)
-    params.componentCarrierId = 0; // the component carrier id (NOT USED)
-    params.rnti = rntiDest; // the C-RNTI identifying the destination
-    params.lcid = bsrIt->second.lcid; // the logical channel id
-    macSapUser->NotifyTxOpportunity (params);
-
-    // update the entry in the m_bufferStatusReportMap (delete it if no
-    // further resources are needed)
-    bsrIt = UpdateBufferStatusReport (bsrIt->second.lcid, assignedBytes);
-
-    // update the number of available symbols
-    availableSymbols -= assignedSymbols;
-
-    // update the availableSymbolsPerLc (if needed)
-    if (availableSymbols < availableSymbolsPerLc)
+  // collect the state of the active logical channels
+  SlSchedulerParams params;
+  params.timingInfo = timingInfo;
+  params.availableSymbols = m_phyMacConfig->GetSymbPerSlot () - firstSymbol;
+  params.subChannelSize = m_subChannelSize;
+  for (const auto& bsr : m_bufferStatusReportMap)
+  {
+    // skip the destinations whose HARQ processes are all busy
+    if (m_harq && !HasFreeHarqProcess (bsr.second.rnti))
     {
-      availableSymbolsPerLc = availableSymbols;
+      NS_LOG_DEBUG ("No free HARQ process for rnti " << bsr.second.rnti);
+      continue;
     }
 
-    // update index to the next available symbol
-    symStart = symStart + assignedSymbols;
+    SlSchedulerLcInfo lc;
+    lc.lcid = bsr.first;
+    lc.rnti = bsr.second.rnti;
+    lc.mcs = GetMcs (bsr.second.rnti);
+    lc.requiredBytes = bsr.second.txQueueSize + bsr.second.retxQueueSize + bsr.second.statusPduSize;
+    lc.holDelay = std::max (bsr.second.txQueueHolDelay, bsr.second.retxQueueHolDelay);
+    params.lcs.push_back (lc);
+  }
+
+  if (params.lcs.empty ())
+  {
+    return allocationInfo;
+  }
+
+  NS_LOG_DEBUG("availableSymbols =\t" << params.availableSymbols);
+
+  // if no table has been shared by the helper, build one for this device
+  if (!m_tbSizeTable)
+  {
+    SetTbSizeTable (Create<MmWaveSidelinkTbSizeTable> (m_phyMacConfig));
+  }
+
+  // let the scheduler decide how to allocate the resources, then notify
+  // the RLC of each grant
+  std::vector<SlSchedulerGrant> grants = m_scheduler->Schedule (params);
+
+  // the slot is used up to the end of the last grant, the grants on
+  // different sub-channels may overlap in time
+  uint32_t usedSymbols = firstSymbol;
+  for (const SlSchedulerGrant& grant : grants)
+  {
+    usedSymbols = std::max<uint32_t> (usedSymbols, firstSymbol + grant.symStart + grant.numSym);
+  }
+  double slotUtilization = double (usedSymbols) / m_phyMacConfig->GetSymbPerSlot ();
+  NS_LOG_DEBUG ("slotUtilization =\t" << slotUtilization);
+
+  for (const SlSchedulerGrant& grant : grants)
+  {
+    AllocateTransportBlock (timingInfo, grant.lcid, firstSymbol + grant.symStart, grant.numSym, grant.mcs, grant.tbSize, grant.rbMask, slotUtilization, allocationInfo);
+  }
+  return allocationInfo;
+}
 
-    // if the iterator reached the end of the map, start again
-    if (bsrIt == m_bufferStatusReportMap.end ())
+void
+MmWaveSidelinkMac::AllocateTransportBlock (mmwave::SfnSf timingInfo, uint8_t lcid, uint8_t symStart, uint8_t numSym,
+                                           uint8_t mcs, uint32_t tbSize, Ptr<const MmWaveSidelinkRbMask> rbMask,
+                                           double slotUtilization, std::vector<SlTtiAllocInfo>& allocationInfo)
+{
+  uint16_t rntiDest = m_bufferStatusReportMap.at (lcid).rnti; // the RNTI of the destination node
+
+  // create the SlTtiAllocInfo object
+  SlTtiAllocInfo info;
+  info.m_ttiIdx = timingInfo.m_slotNum; // the TB will be sent in this slot
+  info.m_rnti = rntiDest; // the RNTI of the destination node
+  info.m_dci.m_rnti = m_rnti; // my RNTI
+  info.m_dci.m_numSym = numSym; // the number of symbols required to tx the packet
+  info.m_dci.m_symStart = symStart; // index of the first available symbol
+  info.m_dci.m_mcs = mcs;
+  info.m_dci.m_tbSize = tbSize; // the TB size in bytes
+  info.m_dci.m_harqProcess = 0; // set by StartHarqProcess if HARQ is used
+  info.m_dci.m_ndi = 0;
+  info.m_dci.m_rv = 0; // first transmission
+  info.m_ttiType = mmwave::TtiAllocInfo::TddTtiType::DATA; // the TB carries data
+  info.m_rbMask = rbMask; // the RBs used by the TB
+  if (m_txPowerControl)
+  {
+    info.m_txPower = GetTxPower (rntiDest); // otherwise the PHY tx power is used
+  }
+
+  NS_LOG_DEBUG("info.m_dci.m_tbSize =\t" << info.m_dci.m_tbSize);
+
+  // if the previous TB is for the same destination, uses all the RBs and ends
+  // where this one starts, extend it instead of creating a new TB, so that
+  // the PDUs of the different logical channels are sent together
+  bool merged = false;
+  if (!allocationInfo.empty () && !rbMask)
+  {
+    SlTtiAllocInfo& last = allocationInfo.back ();
+    if (last.m_rnti == rntiDest && !last.m_rbMask && last.m_dci.m_mcs == mcs &&
+        last.m_dci.m_symStart + last.m_dci.m_numSym == symStart)
     {
-      bsrIt = m_bufferStatusReportMap.begin ();
+      last.m_dci.m_numSym += numSym;
+      last.m_dci.m_tbSize += tbSize;
+      merged = true;
+      NS_LOG_DEBUG ("Extend the TB for rnti " << rntiDest << " to " << last.m_dci.m_tbSize << " bytes");
     }
+  }
 
+  if (!merged)
+  {
+    allocationInfo.push_back (info);
   }
-  return allocationInfo;
+
+  // fire the scheduling trace for this grant. If the grant has been merged
+  // with the previous one, the transport block is the sum of both entries
+  SlSchedulingCallback traceInfo;
+  traceInfo.frame = timingInfo.m_frameNum;
+  traceInfo.subframe = timingInfo.m_sfNum;
+  traceInfo.slotNum = timingInfo.m_slotNum;
+  traceInfo.symStart = symStart;
+  traceInfo.numSym = numSym;
+  traceInfo.mcs = mcs;
+  traceInfo.tbSize = tbSize;
+  traceInfo.txRnti = m_rnti;
+  traceInfo.rxRnti = rntiDest;
+  traceInfo.rbStart = rbMask ? rbMask->GetIndexes ().front () : 0;
+  traceInfo.numRbs = rbMask ? rbMask->GetNumRbs () : m_phyMacConfig->GetNumRb ();
+  traceInfo.txPower = info.m_txPower;
+  traceInfo.slotUtilization = slotUtilization;
+  m_schedulingTrace (traceInfo);
+
+  // notify the RLC
+  LteMacSapUser* macSapUser = m_lcidToMacSap.find (lcid)->second;
+  LteMacSapUser::TxOpportunityParameters params;
+  params.bytes = tbSize;  // the number of bytes to transmit
+  params.layer = 0;  // the layer of transmission (MIMO) (NOT USED)
+  params.harqId = 0; // the HARQ ID (NOT USED)
+  params.componentCarrierId = 0; // the component carrier id (NOT USED)
+  params.rnti = rntiDest; // the C-RNTI identifying the destination
+  params.lcid = lcid; // the logical channel id
+  macSapUser->NotifyTxOpportunity (params);
+
+  // update the entry in the m_bufferStatusReportMap (delete it if no
+  // further resources are needed)
+  UpdateBufferStatusReport (lcid, tbSize);
 }
 
 std::map<uint8_t, LteMacSapProvider::ReportBufferStatusParameters>::iterator
@@ -366,6 +797,136 @@ MmWaveSidelinkMac::UpdateBufferStatusReport (uint8_t lcid, uint32_t assignedByte
   return bsrIt;
 }
 
+std::vector<MmWaveSidelinkMac::SlHarqProcess>&
+MmWaveSidelinkMac::GetHarqProcesses (uint16_t rnti)
+{
+  auto it = m_harqProcesses.find (rnti);
+  if (it == m_harqProcesses.end ())
+  {
+    SlHarqProcess process;
+    process.active = false;
+    process.pendingRetx = false;
+    process.ndi = 0;
+    process.numRetx = 0;
+    std::vector<SlHarqProcess> processes (m_numHarqProcesses, process);
+    it = m_harqProcesses.insert (std::make_pair (rnti, processes)).first;
+  }
+  return it->second;
+}
+
+bool
+MmWaveSidelinkMac::HasFreeHarqProcess (uint16_t rnti)
+{
+  const std::vector<SlHarqProcess>& processes = GetHarqProcesses (rnti);
+  return std::any_of (processes.begin (), processes.end (),
+                      [] (const SlHarqProcess& p) { return !p.active; });
+}
+
+void
+MmWaveSidelinkMac::StartHarqProcess (Ptr<PacketBurst> pb, SlTtiAllocInfo& info)
+{
+  std::vector<SlHarqProcess>& processes = GetHarqProcesses (info.m_rnti);
+  auto process = std::find_if (processes.begin (), processes.end (),
+                               [] (const SlHarqProcess& p) { return !p.active; });
+  if (process == processes.end ())
+  {
+    // this may happen if several TBs are sent to the same destination in
+    // the same slot
+    NS_LOG_DEBUG ("No free HARQ process for rnti " << info.m_rnti << ", send the TB without HARQ");
+    info.m_dci.m_harqProcess = SL_NO_HARQ_PROCESS;
+    return;
+  }
+
+  // toggle the NDI, so that the receiver discards the history of the
+  // previous TB sent with this process
+  process->active = true;
+  process->pendingRetx = false;
+  process->ndi = 1 - process->ndi;
+  process->numRetx = 0;
+  process->txTime = Simulator::Now ();
+
+  info.m_dci.m_harqProcess = std::distance (processes.begin (), process);
+  info.m_dci.m_ndi = process->ndi;
+  info.m_dci.m_rv = 0;
+
+  process->pb = pb;
+  process->info = info;
+
+  NS_LOG_DEBUG ("TB for rnti " << info.m_rnti << " sent with HARQ process " << uint16_t (info.m_dci.m_harqProcess));
+}
+
+void
+MmWaveSidelinkMac::NackHarqProcess (uint16_t rnti, uint8_t harqId)
+{
+  SlHarqProcess& process = GetHarqProcesses (rnti) [harqId];
+  if (process.numRetx < m_maxHarqRetx)
+  {
+    NS_LOG_DEBUG ("Queue the retransmission of HARQ process " << uint16_t (harqId) << " for rnti " << rnti);
+    process.pendingRetx = true;
+    m_harqRetxQueue.push_back (std::make_pair (rnti, harqId));
+  }
+  else
+  {
+    NS_LOG_DEBUG ("Maximum number of retransmissions reached, discard the TB of HARQ process " << uint16_t (harqId) << " for rnti " << rnti);
+    process.active = false;
+    process.pb = nullptr;
+  }
+}
+
+uint8_t
+MmWaveSidelinkMac::ScheduleHarqRetransmissions (mmwave::SfnSf timingInfo)
+{
+  // the feedback is sent at the end of the reception, hence it is received
+  // by the following slot. If it did not arrive by then the TB has not been
+  // received (e.g., because the destination was not listening)
+  Time timeout = m_phyMacConfig->GetSlotPeriod () * 2;
+  for (auto& destination : m_harqProcesses)
+  {
+    for (uint32_t harqId = 0; harqId < destination.second.size (); harqId++)
+    {
+      const SlHarqProcess& process = destination.second [harqId];
+      if (process.active && !process.pendingRetx && Simulator::Now () - process.txTime >= timeout)
+      {
+        NS_LOG_DEBUG ("No feedback for HARQ process " << harqId << " of rnti " << destination.first);
+        NackHarqProcess (destination.first, harqId);
+      }
+    }
+  }
+
+  // send the retransmissions one after the other, with the same parameters
+  // of the first transmission, until they fit in the slot
+  uint8_t symStart = 0;
+  auto it = m_harqRetxQueue.begin ();
+  while (it != m_harqRetxQueue.end ())
+  {
+    SlHarqProcess& process = GetHarqProcesses (it->first) [it->second];
+    if (symStart + process.info.m_dci.m_numSym > m_phyMacConfig->GetSymbPerSlot ())
+    {
+      break;
+    }
+
+    process.numRetx++;
+    process.pendingRetx = false;
+    process.txTime = Simulator::Now ();
+
+    SlTtiAllocInfo info = process.info;
+    info.m_ttiIdx = timingInfo.m_slotNum;
+    info.m_dci.m_symStart = symStart;
+    info.m_dci.m_rv = std::min<uint8_t> (process.numRetx, 3);
+    if (m_txPowerControl)
+    {
+      info.m_txPower = GetTxPower (it->first);
+    }
+
+    NS_LOG_DEBUG ("Retransmission " << uint16_t (process.numRetx) << " of HARQ process " << uint16_t (it->second) << " for rnti " << it->first);
+    m_phySapProvider->AddTransportBlock (process.pb, info);
+
+    symStart += info.m_dci.m_numSym;
+    it = m_harqRetxQueue.erase (it);
+  }
+  return symStart;
+}
+
 void
 MmWaveSidelinkMac::DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusParameters params)
 {
@@ -382,6 +943,91 @@ MmWaveSidelinkMac::DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusPa
     m_bufferStatusReportMap.insert (std::make_pair (params.lcid, params));
     NS_LOG_DEBUG("Insert buffer status report for LCID " << uint32_t(params.lcid));
   }
+
+  // wake up the PHY, in case it is skipping the idle slots
+  m_phySapProvider->NotifyTrafficPending ();
+}
+
+void
+MmWaveSidelinkMac::DoSlSensingReport (mmwave::SfnSf timingInfo, uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm)
+{
+  NS_LOG_FUNCTION (this << senderRnti << destinationRnti << rssiDbm);
+
+  if (m_resourceSelection != SENSING_BASED)
+  {
+    return;
+  }
+
+  // store the measurement and discard those older than the sensing window
+  SlSensingRecord record;
+  record.time = Simulator::Now ();
+  record.slotNum = timingInfo.m_slotNum;
+  record.rssiDbm = rssiDbm;
+  m_sensingRecords.push_back (record);
+  while (Simulator::Now () - m_sensingRecords.front ().time > m_sensingWindow)
+  {
+    m_sensingRecords.pop_front ();
+  }
+
+  if (destinationRnti == m_rnti)
+  {
+    m_sensedSlotOwner [timingInfo.m_slotNum] = std::make_pair (senderRnti, Simulator::Now ());
+  }
+}
+
+bool
+MmWaveSidelinkMac::HasPendingData () const
+{
+  bool pendingData = !m_bufferStatusReportMap.empty () || m_txQueuePackets > 0;
+  for (auto it = m_harqProcesses.begin (); !pendingData && it != m_harqProcesses.end (); it++)
+  {
+    pendingData = std::any_of (it->second.begin (), it->second.end (),
+                               [] (const SlHarqProcess& p) { return p.active; });
+  }
+  return pendingData;
+}
+
+std::vector<uint8_t>
+MmWaveSidelinkMac::GetReservedSlots () const
+{
+  return m_reservedSlots;
+}
+
+int64_t
+MmWaveSidelinkMac::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uniformRv->SetStream (stream);
+  return 1;
+}
+
+uint32_t
+MmWaveSidelinkMac::DoGetSlotsUntilNextActivity (mmwave::SfnSf timingInfo)
+{
+  NS_LOG_FUNCTION (this);
+
+  // with the sensing-based resource selection the device has to sense and
+  // possibly receive in every slot
+  if (m_resourceSelection == SENSING_BASED)
+  {
+    return 1;
+  }
+
+  // check if there is data waiting to be transmitted
+  bool pendingData = HasPendingData ();
+
+  // look for the next slot assigned to this device (if there is data to
+  // transmit) or to another device, which may transmit
+  uint32_t numSlots = m_sfAllocInfo.size ();
+  for (uint32_t i = 1; i < numSlots; i++)
+  {
+    uint16_t rnti = m_sfAllocInfo [(timingInfo.m_slotNum + i) % numSlots];
+    if ((rnti == m_rnti && pendingData) || (rnti != 0 && rnti != m_rnti))
+    {
+      return i;
+    }
+  }
+  return numSlots;
 }
 
 void
@@ -394,17 +1040,68 @@ MmWaveSidelinkMac::DoTransmitPdu (LteMacSapProvider::TransmitPduParameters param
   //insert the packet at the end of the buffer
   NS_LOG_DEBUG("Add packet for RNTI " << params.rnti << " LCID " << uint32_t(params.lcid));
 
-  auto it = m_txBufferMap.find (params.rnti);
-  if (it == m_txBufferMap.end ())
+  SlTxQueue* txQueue = GetTxQueue (params.rnti);
+  NS_ASSERT_MSG (txQueue != nullptr, "RNTI " << params.rnti << " is not a peer of this device");
+
+  // the RLC sends at most the PDUs which fit in the grants of the current
+  // slot, hence the queue has to be enlarged only if the grants are large
+  if (txQueue->pdus.IsFull ())
   {
-    std::list<LteMacSapProvider::TransmitPduParameters> txBuffer;
-    txBuffer.push_back (params);
-    m_txBufferMap.insert (std::make_pair (params.rnti, txBuffer));
+    uint32_t capacity = 2 * txQueue->pdus.GetCapacity ();
+    NS_LOG_LOGIC ("Enlarge the tx queue of RNTI " << params.rnti << " to " << capacity << " PDUs");
+    txQueue->pdus.SetCapacity (capacity);
   }
-  else
+
+  txQueue->pdus.PushBack (params);
+  txQueue->bytes += params.pdu->GetSize ();
+  m_txQueueBytes += params.pdu->GetSize ();
+  m_txQueuePackets++;
+}
+
+uint32_t
+MmWaveSidelinkMac::AddPeer (uint16_t rnti)
+{
+  NS_LOG_FUNCTION (this << rnti);
+
+  if (rnti >= m_peerIndexMap.size ())
+  {
+    m_peerIndexMap.resize (rnti + 1, SL_NO_PEER);
+  }
+
+  // allocate the tx queue of the peer, if it was not already added
+  if (m_peerIndexMap [rnti] == SL_NO_PEER)
+  {
+    SlTxQueue txQueue;
+    txQueue.rnti = rnti;
+    txQueue.pdus.SetCapacity (m_txQueueCapacity);
+    txQueue.bytes = 0;
+    m_peerIndexMap [rnti] = m_txQueues.size ();
+    m_txQueues.push_back (txQueue);
+    NS_LOG_DEBUG ("RNTI " << rnti << " has peer index " << m_peerIndexMap [rnti]);
+  }
+  return m_peerIndexMap [rnti];
+}
+
+MmWaveSidelinkMac::SlTxQueue*
+MmWaveSidelinkMac::GetTxQueue (uint16_t rnti)
+{
+  if (rnti >= m_peerIndexMap.size () || m_peerIndexMap [rnti] == SL_NO_PEER)
   {
-    it->second.push_back (params);
+    return nullptr;
   }
+  return &m_txQueues [m_peerIndexMap [rnti]];
+}
+
+uint32_t
+MmWaveSidelinkMac::GetTxQueueBytes () const
+{
+  return m_txQueueBytes;
+}
+
+uint32_t
+MmWaveSidelinkMac::GetTxQueuePackets () const
+{
+  return m_txQueuePackets;
 }
 
 void
@@ -468,6 +1165,62 @@ MmWaveSidelinkMac::SetSfAllocationInfo (std::vector<uint16_t> pattern)
   m_sfAllocInfo = pattern;
 }
 
+void
+MmWaveSidelinkMac::SetSchedulerType (TypeId type)
+{
+  NS_LOG_FUNCTION (this << type);
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  m_scheduler = factory.Create<MmWaveSidelinkScheduler> ();
+  m_scheduler->SetConfiguration (m_phyMacConfig, m_tbSizeTable);
+}
+
+TypeId
+MmWaveSidelinkMac::GetSchedulerType () const
+{
+  return m_scheduler ? m_scheduler->GetInstanceTypeId () : TypeId ();
+}
+
+Ptr<MmWaveSidelinkScheduler>
+MmWaveSidelinkMac::GetScheduler () const
+{
+  return m_scheduler;
+}
+
+void
+MmWaveSidelinkMac::SetTbSizeTable (Ptr<const MmWaveSidelinkTbSizeTable> tbSizeTable)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (tbSizeTable->GetConfigurationParameters () == m_phyMacConfig,
+                 "The TB size table was built with different configuration parameters");
+  m_tbSizeTable = tbSizeTable;
+  if (m_scheduler)
+  {
+    m_scheduler->SetConfiguration (m_phyMacConfig, m_tbSizeTable);
+  }
+}
+
+Ptr<const MmWaveSidelinkTbSizeTable>
+MmWaveSidelinkMac::GetTbSizeTable () const
+{
+  return m_tbSizeTable;
+}
+
+std::vector<int>
+MmWaveSidelinkMac::GetCqiHistory (uint16_t rnti) const
+{
+  std::vector<int> history;
+  auto it = m_slCqiReported.find (rnti);
+  if (it != m_slCqiReported.end ())
+  {
+    for (uint32_t i = 0; i < it->second.cqiHistory.GetSize (); i++)
+    {
+      history.push_back (it->second.cqiHistory [i]);
+    }
+  }
+  return history;
+}
+
 void
 MmWaveSidelinkMac::SetForwardUpCallback (Callback <void, Ptr<Packet> > cb)
 {
@@ -475,24 +1228,127 @@ MmWaveSidelinkMac::SetForwardUpCallback (Callback <void, Ptr<Packet> > cb)
 }
 
 void
-MmWaveSidelinkMac::DoSlSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize)
+MmWaveSidelinkMac::DoSlSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report)
 {
   NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG ("Average SINR with dev " << report.rnti << " = " << report.sinr.meanDb);
+
+  SlLinkQualityState& state = GetLinkQualityState (report.rnti);
+
+  // compute the CQI. The SINR offset of the outer loop link adaptation is
+  // applied by GetMcs, so that the filtered CQI is not biased by old offsets
+  uint8_t mcs; // the MCS returned by the AMC, not used
+  int cqi = m_amc->CreateCqiFeedbackWbTdma (sinr, mcs);
 
-  // check if the m_slCqiReported already contains the CQI history for the device
-  // with RNTI = rnti. If so, add the new CQI report, otherwise create a new
-  // entry.
-  uint8_t mcs; // the selected MCS will be stored in this variable
-  if (m_slCqiReported.find (rnti) != m_slCqiReported.end () )
+  // store the CQI, dropping the oldest one if the history is full
+  if (state.cqiHistory.IsEmpty ())
   {
-    m_slCqiReported.at (rnti).push_back (m_amc->CreateCqiFeedbackWbTdma (sinr, mcs));
+    state.filteredCqi = cqi;
   }
-  else
+  if (state.cqiHistory.IsFull ())
+  {
+    state.cqiHistory.PopFront ();
+  }
+  state.cqiHistory.PushBack (cqi);
+
+  // update the filtered CQI, and keep the SINR to map the offset of the
+  // outer loop link adaptation to a CQI offset
+  state.filteredCqi = m_cqiFilterWeight * cqi + (1 - m_cqiFilterWeight) * state.filteredCqi;
+  state.lastUpdate = Simulator::Now ();
+  if (m_olla)
+  {
+    state.lastSinr = sinr.Copy ();
+    state.lastCqi = cqi;
+    UpdateCqiOffset (state);
+  }
+
+  NS_LOG_DEBUG ("CQI from dev " << report.rnti << " = " << cqi << ", filtered CQI = " << state.filteredCqi);
+
+  // feed the SINR and the outcome of the decoding back to the transmitter,
+  // which uses them for the power control, the link adaptation and HARQ
+  if (m_txPowerControl || m_olla || m_harq)
+  {
+    SlFeedbackInfo feedback;
+    feedback.rnti = m_rnti;
+    feedback.sinrDb = report.sinr.meanDb;
+    feedback.ack = !report.corrupt;
+    feedback.harqId = report.harqId;
+    m_phySapProvider->SendFeedback (report.rnti, feedback);
+  }
+}
+
+void
+MmWaveSidelinkMac::DoReceiveFeedback (SlFeedbackInfo feedback)
+{
+  NS_LOG_FUNCTION (this << feedback.rnti << feedback.sinrDb << feedback.ack);
+
+  // release the HARQ process or queue the TB for retransmission. The
+  // feedback of the TBs sent without HARQ is ignored
+  if (m_harq && feedback.harqId < m_numHarqProcesses)
+  {
+    SlHarqProcess& process = GetHarqProcesses (feedback.rnti) [feedback.harqId];
+    if (process.active && !process.pendingRetx)
+    {
+      if (feedback.ack)
+      {
+        NS_LOG_DEBUG ("ACK for HARQ process " << uint16_t (feedback.harqId) << " of rnti " << feedback.rnti);
+        process.active = false;
+        process.pb = nullptr;
+      }
+      else
+      {
+        NackHarqProcess (feedback.rnti, feedback.harqId);
+      }
+    }
+  }
+
+  // update the SINR offset so that, at regime, the fraction of failed
+  // transport blocks is equal to the target BLER
+  if (m_olla)
+  {
+    SlLinkQualityState& state = GetLinkQualityState (feedback.rnti);
+    if (feedback.ack)
+    {
+      state.sinrOffset -= m_ollaStepUp * m_targetBler / (1 - m_targetBler);
+    }
+    else
+    {
+      state.sinrOffset += m_ollaStepUp;
+    }
+    state.sinrOffset = std::max (-m_ollaMaxOffset, std::min (state.sinrOffset, m_ollaMaxOffset));
+    UpdateCqiOffset (state);
+    m_sinrOffsetTrace (feedback.rnti, state.sinrOffset);
+  }
+
+  if (!m_txPowerControl)
+  {
+    return;
+  }
+
+  // increase the power if the SINR is below the target, decrease it if the
+  // SINR is above the target by more than one step, so that the loop does
+  // not oscillate around the target
+  double txPower = GetTxPower (feedback.rnti);
+  if (feedback.sinrDb < m_targetSinr)
   {
-    std::vector<int> cqiTemp;
-    cqiTemp.push_back (m_amc->CreateCqiFeedbackWbTdma (sinr, mcs));
-    m_slCqiReported.insert (std::make_pair(rnti, cqiTemp));
+    txPower = std::min (txPower + m_txPowerStep, m_maxTxPower);
   }
+  else if (feedback.sinrDb > m_targetSinr + m_txPowerStep)
+  {
+    txPower = std::max (txPower - m_txPowerStep, m_minTxPower);
+  }
+
+  NS_LOG_DEBUG ("SINR at dev " << feedback.rnti << " = " << feedback.sinrDb << " dB, tx power = " << txPower << " dBm");
+  m_txPowerMap [feedback.rnti] = txPower;
+  m_txPowerTrace (feedback.rnti, txPower);
+}
+
+double
+MmWaveSidelinkMac::GetTxPower (uint16_t rnti) const
+{
+  // use the maximum power until the first feedback is received
+  auto it = m_txPowerMap.find (rnti);
+  return it != m_txPowerMap.end () ? it->second : m_maxTxPower;
 }
 
 uint8_t
@@ -503,15 +1359,18 @@ MmWaveSidelinkMac::GetMcs (uint16_t rnti)
   uint8_t mcs; // the selected MCS
   if (m_useAmc)
   {
-    // if AMC is used, select the MCS based on the CQI history
-    if (m_slCqiReported.find (rnti) != m_slCqiReported.end ())
+    // if AMC is used, select the MCS based on the filtered CQI corrected by
+    // the outer loop link adaptation, unless it is not available or too old
+    auto it = m_slCqiReported.find (rnti);
+    if (it != m_slCqiReported.end () && !it->second.cqiHistory.IsEmpty () &&
+        (m_cqiExpirationTime.IsZero () || Simulator::Now () - it->second.lastUpdate <= m_cqiExpirationTime))
     {
-      std::vector <int> cqi = m_slCqiReported.find (rnti)->second;
-      mcs = m_amc->GetMcsFromCqi(cqi.back ());
+      long cqi = std::lround (it->second.filteredCqi) + it->second.cqiOffset;
+      mcs = m_amc->GetMcsFromCqi (std::max (0L, std::min (cqi, 15L)));
     }
     else
     {
-      mcs = 0; // if the CQI history not found for this device, use the minimum MCS value
+      mcs = m_fallbackMcs;
     }
   }
   else
@@ -519,10 +1378,41 @@ MmWaveSidelinkMac::GetMcs (uint16_t rnti)
     // if AMC is not used, use a fixed MCS value
     mcs = m_mcs;
   }
-  // TODO: update the method to refresh CQI reports and delete older reports
   return mcs;
 }
 
+MmWaveSidelinkMac::SlLinkQualityState&
+MmWaveSidelinkMac::GetLinkQualityState (uint16_t rnti)
+{
+  auto it = m_slCqiReported.find (rnti);
+  if (it == m_slCqiReported.end ())
+  {
+    SlLinkQualityState state;
+    state.cqiHistory.SetCapacity (m_cqiHistorySize);
+    state.filteredCqi = 0;
+    state.sinrOffset = 0;
+    state.lastCqi = 0;
+    state.cqiOffset = 0;
+    it = m_slCqiReported.insert (std::make_pair (rnti, state)).first;
+  }
+  return it->second;
+}
+
+void
+MmWaveSidelinkMac::UpdateCqiOffset (SlLinkQualityState& state)
+{
+  // the CQI offset is the change of the CQI of the last report when its
+  // SINR is reduced by the SINR offset
+  if (state.sinrOffset == 0 || !state.lastSinr)
+  {
+    state.cqiOffset = 0;
+    return;
+  }
+  uint8_t mcs; // the MCS returned by the AMC, not used
+  int cqi = m_amc->CreateCqiFeedbackWbTdma (*state.lastSinr * std::pow (10, -state.sinrOffset / 10), mcs);
+  state.cqiOffset = cqi - state.lastCqi;
+}
+
 void
 MmWaveSidelinkMac::AddMacSapUser (uint8_t lcid, LteMacSapUser* macSapUser)
 {
@@ -21,15 +21,25 @@
 #define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_MAC_H_
 
 #include "mmwave-sidelink-sap.h"
+#include "mmwave-sidelink-scheduler.h"
+#include "mmwave-sidelink-ring-buffer.h"
 #include "ns3/mmwave-amc.h"
 #include "ns3/mmwave-phy-mac-common.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <deque>
 
 namespace ns3 {
 
 namespace millicar {
 
-/// structure used for the scheduling info callback
+/**
+ * Structure used for the scheduling info callback. It describes a single
+ * grant: the grants of different logical channels towards the same device
+ * may be merged in a single transport block, which is then described by
+ * several entries
+ */
 struct SlSchedulingCallback
 {
   uint16_t frame; //!< frame number
@@ -41,6 +51,10 @@ struct SlSchedulingCallback
   uint16_t tbSize; //!< the TB size in bytes
   uint16_t txRnti; //!< the RNTI which identifies the sender
   uint16_t rxRnti; //!< the RNTI which identifies the destination
+  uint16_t rbStart; //!< index of the first allocated RB
+  uint16_t numRbs; //!< number of allocated RBs
+  double txPower; //!< the tx power in dBm, NaN if the tx power of the PHY is used
+  double slotUtilization; //!< fraction of the symbols of the slot allocated by the device, including the HARQ retransmissions
 };
 
 class MmWaveSidelinkMac : public Object
@@ -56,6 +70,12 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * Identifies how the slots used by the device are selected
+   */
+  enum ResourceSelectionMode_t {STATIC_PATTERN = 1, //!< the slots are assigned by the pattern set with SetSfAllocationInfo
+                                SENSING_BASED = 2}; //!< the device selects its slots based on the sensed occupancy
+
   /**
    * \brief Delete default constructor to avoid misuse
    */
@@ -122,6 +142,23 @@ public:
   */
   void SetSfAllocationInfo (std::vector<uint16_t> pattern);
 
+  /**
+  * \brief return the slots reserved by the device with the sensing-based
+  *        resource selection
+  * \return the indexes of the reserved slots in the subframe
+  */
+  std::vector<uint8_t> GetReservedSlots () const;
+
+  /**
+  * Assign a fixed random variable stream number to the random variables
+  * used by this model. Return the number of streams (possibly zero) that
+  * have been assigned.
+  *
+  * \param stream first stream index to use
+  * \return the number of stream indices assigned by this model
+  */
+  int64_t AssignStreams (int64_t stream);
+
   /**
   * \brief Transmit PDU function
   */
@@ -133,6 +170,67 @@ public:
    */
   void SetForwardUpCallback (Callback <void, Ptr<Packet> > cb);
 
+  /**
+   * \brief register a device with which this device communicates and
+   *        allocate its tx queue. It is called when a bearer towards the
+   *        device is activated, adding the same device again has no effect
+   * \param rnti the RNTI of the device
+   * \return the local index of the device, assigned in order of addition
+   */
+  uint32_t AddPeer (uint16_t rnti);
+
+  /**
+   * \brief return the number of bytes waiting in the tx queues
+   * \return the number of bytes
+   */
+  uint32_t GetTxQueueBytes () const;
+
+  /**
+   * \brief return the number of PDUs waiting in the tx queues
+   * \return the number of PDUs
+   */
+  uint32_t GetTxQueuePackets () const;
+
+  /**
+   * \brief set the type of scheduler and create a new instance
+   * \param type the TypeId of a subclass of MmWaveSidelinkScheduler
+   */
+  void SetSchedulerType (TypeId type);
+
+  /**
+   * \brief return the type of scheduler
+   * \return the TypeId of the scheduler
+   */
+  TypeId GetSchedulerType () const;
+
+  /**
+   * \brief return the scheduler
+   * \return the scheduler instance
+   */
+  Ptr<MmWaveSidelinkScheduler> GetScheduler () const;
+
+  /**
+   * \brief set the table used by the scheduler to compute the TB sizes. The
+   *        same table can be shared by all the MACs with the same
+   *        configuration parameters. If it is not set, the MAC builds its
+   *        own table before the first scheduling decision
+   * \param tbSizeTable the TB size table
+   */
+  void SetTbSizeTable (Ptr<const MmWaveSidelinkTbSizeTable> tbSizeTable);
+
+  /**
+   * \brief return the table used by the scheduler to compute the TB sizes
+   * \return the TB size table
+   */
+  Ptr<const MmWaveSidelinkTbSizeTable> GetTbSizeTable () const;
+
+  /**
+   * \brief return the last CQIs reported for a device
+   * \param rnti the RNTI of the device
+   * \return the CQIs, from the oldest to the latest, at most CqiHistorySize
+   */
+  std::vector<int> GetCqiHistory (uint16_t rnti) const;
+
   /**
    * TracedCallback signature for SL scheduling
    *
@@ -140,6 +238,31 @@ public:
    */
   typedef void (* SlSchedulingTracedCallback) (SlSchedulingCallback params);
 
+  /**
+   * TracedCallback signature for the tx power selected by the power control
+   *
+   * \param rnti the RNTI of the destination device
+   * \param txPower the tx power in dBm
+   */
+  typedef void (* TxPowerTracedCallback) (uint16_t rnti, double txPower);
+
+  /**
+   * TracedCallback signature for the SINR offset of the outer loop link
+   * adaptation
+   *
+   * \param rnti the RNTI of the destination device
+   * \param offset the SINR offset in dB
+   */
+  typedef void (* SinrOffsetTracedCallback) (uint16_t rnti, double offset);
+
+  /**
+   * TracedCallback signature for the selection of the resources
+   *
+   * \param rnti the RNTI of the device
+   * \param slotNum the index of the selected slot in the subframe
+   */
+  typedef void (* ResourceSelectionTracedCallback) (uint16_t rnti, uint8_t slotNum);
+
   /**
    * Associate a MAC SAP user instance to the LCID and add it in the map
    * \param lcid Logical Channel ID
@@ -148,6 +271,55 @@ public:
   void AddMacSapUser (uint8_t lcid, LteMacSapUser* macSapUser);
 
 private:
+  /**
+   * Link quality towards a device, built from the CQIs reported for the
+   * transport blocks received from it
+   */
+  struct SlLinkQualityState
+  {
+    RingBuffer<int> cqiHistory; //!< the last CQIs reported
+    double filteredCqi; //!< the exponential moving average of the CQIs, without the SINR offset
+    Time lastUpdate; //!< the time of the last CQI report
+    double sinrOffset; //!< the offset subtracted from the SINR by the outer loop link adaptation in dB
+    Ptr<SpectrumValue> lastSinr; //!< the SINR of the last report, used to map the SINR offset to a CQI offset
+    int lastCqi; //!< the CQI of the last report
+    int cqiOffset; //!< the change of the CQI of the last report caused by the SINR offset
+  };
+
+  /**
+   * State of a HARQ process used to transmit to a device
+   */
+  struct SlHarqProcess
+  {
+    bool active; //!< true if the transport block is waiting for the feedback or for a retransmission
+    bool pendingRetx; //!< true if the transport block is queued for retransmission
+    uint8_t ndi; //!< the new data indicator, toggled for each new transport block
+    uint8_t numRetx; //!< the number of retransmissions of the transport block
+    Ptr<PacketBurst> pb; //!< the PDUs carried by the transport block
+    SlTtiAllocInfo info; //!< the scheduling information of the first transmission
+    Time txTime; //!< the start of the slot of the last transmission
+  };
+
+  /**
+   * Queue of the PDUs destined to a device
+   */
+  struct SlTxQueue
+  {
+    uint16_t rnti; //!< the RNTI of the destination device
+    RingBuffer<LteMacSapProvider::TransmitPduParameters> pdus; //!< the PDUs, from the oldest
+    uint32_t bytes; //!< the total size of the PDUs in bytes
+  };
+
+  /**
+   * Received power sensed in a slot
+   */
+  struct SlSensingRecord
+  {
+    Time time; //!< the time of the measurement
+    uint8_t slotNum; //!< the index of the slot in the subframe
+    double rssiDbm; //!< the received power in dBm
+  };
+
   // forwarded from PHY SAP
  /**
   * Receive PHY PDU function
@@ -157,15 +329,15 @@ private:
 
   /**
   * \brief Based on the SINR reported, the CQI is evaluated and pushed to the
-           CQIs history with the latest SINR information
+           CQIs history with the latest SINR information. If the power control
+           or the outer loop link adaptation are used, the SINR and the outcome
+           of the decoding are fed back to the transmitter. The feedback is
+           also sent if HARQ is used.
   * \params sinr SpectrumValue instance representing the SINR measured on all
             the spectrum chunks
-  * \params rnti RNTI of the transmitting device
-  * \params numSym size of the transport block that generated the report in
-            number of OFDM symbols
-  * \params tbSize size of the transport block that generated the report in bytes
+  * \params report information about the received transport block
   */
-  void DoSlSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize);
+  void DoSlSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report);
 
   /**
   * \brief Implements RlcSidelinkMemberMacSapProvider::ReportBufferStatus,
@@ -174,22 +346,183 @@ private:
   */
   void DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusParameters params);
 
+  /**
+  * \brief Returns the number of slots until the next slot in which the MAC
+  *        has something to do
+  * \params timingInfo the SfnSf object of the current slot
+  * \returns the number of slots
+  */
+  uint32_t DoGetSlotsUntilNextActivity (mmwave::SfnSf timingInfo);
+
+  /**
+  * \brief Receive the feedback sent by a destination device. If the power
+  *        control is enabled, the tx power towards that device is adjusted
+  *        to reach the target SINR. If the outer loop link adaptation is
+  *        enabled, the SINR offset of that device is adjusted to reach the
+  *        target BLER. If HARQ is enabled, the HARQ process is released
+  *        after an ACK, or queued for retransmission after a NACK.
+  * \params feedback the feedback
+  */
+  void DoReceiveFeedback (SlFeedbackInfo feedback);
+
+  /**
+  * \brief Store the received power of a sensed signal, used to select the
+  *        slots with the sensing-based resource selection. If the signal is
+  *        destined to this device, the sender is expected to transmit in the
+  *        same slot of the following subframes.
+  * \params timingInfo the SfnSf object of the slot of the signal
+  * \params senderRnti the RNTI of the device which sent the signal
+  * \params destinationRnti the RNTI of the device to which the signal is destined
+  * \params rssiDbm the received power in dBm
+  */
+  void DoSlSensingReport (mmwave::SfnSf timingInfo, uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm);
+
   /////////////////////////////////////////////////////////////////////////////
 
   /**
-  * \brief Evaluate the MCS of the link towards a specific device
+  * \brief Returns the tx queue of a device
+  * \params rnti the RNTI of the device
+  * \returns a pointer to the tx queue, or nullptr if the device is not a peer
+  */
+  SlTxQueue* GetTxQueue (uint16_t rnti);
+
+  /**
+  * \brief Check if there is data waiting to be transmitted, either in the
+  *        RLC, in the MAC or in the HARQ processes
+  * \returns true if there is pending data
+  */
+  bool HasPendingData () const;
+
+  /**
+  * \brief Returns the device which transmits in a slot
+  * \params timingInfo the SfnSf object of the slot
+  * \returns the RNTI of this device if it transmits, the RNTI of the device
+  *          expected to transmit to this device, or 0 if the slot is not used
+  */
+  uint16_t GetSlotOwner (mmwave::SfnSf timingInfo) const;
+
+  /**
+  * \brief With the sensing-based resource selection, update the reservation
+  *        when the reselection counter expires: keep the reserved slots with
+  *        probability ProbResourceKeep, select new ones if there is pending
+  *        data, or release them otherwise
+  * \params timingInfo the SfnSf object of the current slot
+  */
+  void UpdateReservation (mmwave::SfnSf timingInfo);
+
+  /**
+  * \brief Select the slots to reserve. The slots in which the maximum power
+  *        sensed over the sensing window exceeds the threshold are excluded.
+  *        If less than MinCandidateRatio of the slots are left, the
+  *        threshold is increased by 3 dB. The reserved slots are picked at
+  *        random among the candidates.
+  * \returns the indexes of the selected slots, sorted
+  */
+  std::vector<uint8_t> SelectResources ();
+
+  /**
+  * \brief Evaluate the MCS of the link towards a specific device. If AMC is
+  *        used, the MCS corresponds to the filtered CQI corrected by the
+  *        outer loop link adaptation, unless the last report is older than
+  *        the expiration time.
   * \params rnti the RNTI that identifies the device we want to communicate with
   */
   uint8_t GetMcs (uint16_t rnti);
 
+  /**
+  * \brief Returns the link quality state of a device, creating it if needed
+  * \params rnti the RNTI of the device
+  * \returns a reference to the link quality state
+  */
+  SlLinkQualityState& GetLinkQualityState (uint16_t rnti);
+
+  /**
+  * \brief Map the SINR offset of the outer loop link adaptation to the
+  *        offset applied to the filtered CQI, using the SINR of the last report
+  * \params state the link quality state of the device
+  */
+  void UpdateCqiOffset (SlLinkQualityState& state);
+
+  /**
+  * \brief Returns the tx power selected by the power control for the link
+  *        towards a specific device
+  * \params rnti the RNTI that identifies the device we want to communicate with
+  * \returns the tx power in dBm
+  */
+  double GetTxPower (uint16_t rnti) const;
+
   /**
   * \brief Decides how to allocate the available resources to the active
   *        logical channels
   * \params timingInfo the SfnSf object containing the frame, subframe and slot
   *         index
-  * \returns SlotAllocInfo object containing the scheduling information
+  * \params firstSymbol index of the first symbol which can be allocated, the
+  *         previous ones are used by the HARQ retransmissions
+  * \returns the scheduling information of each transport block
   */
-  mmwave::SlotAllocInfo ScheduleResources (mmwave::SfnSf timingInfo);
+  std::vector<SlTtiAllocInfo> ScheduleResources (mmwave::SfnSf timingInfo, uint8_t firstSymbol);
+
+  /**
+  * \brief Returns the HARQ processes used to transmit to a device, creating
+  *        them if needed
+  * \params rnti the RNTI of the device
+  * \returns a reference to the HARQ processes
+  */
+  std::vector<SlHarqProcess>& GetHarqProcesses (uint16_t rnti);
+
+  /**
+  * \brief Check if a HARQ process is available to transmit a new transport
+  *        block to a device
+  * \params rnti the RNTI of the device
+  * \returns true if at least one HARQ process is not active
+  */
+  bool HasFreeHarqProcess (uint16_t rnti);
+
+  /**
+  * \brief Assign a free HARQ process to a new transport block and store it
+  *        for the retransmissions. If no process is available, the transport
+  *        block is sent without HARQ.
+  * \params pb the PDUs carried by the transport block
+  * \params info the scheduling information, updated with the HARQ process ID,
+  *         the NDI and the RV
+  */
+  void StartHarqProcess (Ptr<PacketBurst> pb, SlTtiAllocInfo& info);
+
+  /**
+  * \brief Queue a HARQ process for retransmission, or release it if the
+  *        maximum number of retransmissions has been reached
+  * \params rnti the RNTI of the destination device
+  * \params harqId the HARQ process ID
+  */
+  void NackHarqProcess (uint16_t rnti, uint8_t harqId);
+
+  /**
+  * \brief Treat as lost the transport blocks whose feedback did not arrive in
+  *        time, then send the queued retransmissions at the beginning of the
+  *        slot, in the order in which they were queued
+  * \params timingInfo the SfnSf object of the current slot
+  * \returns the number of symbols used by the retransmissions
+  */
+  uint8_t ScheduleHarqRetransmissions (mmwave::SfnSf timingInfo);
+
+  /**
+  * \brief Allocate a transport block to a logical channel, notify the RLC and
+  *        update the buffer status report
+  * \params timingInfo the SfnSf object of the current slot
+  * \params lcid the logical channel ID
+  * \params symStart index of the first symbol
+  * \params numSym number of symbols
+  * \params mcs the MCS
+  * \params tbSize the TB size in bytes
+  * \params rbMask the RBs used by the transport block, if null all the RBs
+  *         are used
+  * \params slotUtilization the fraction of the symbols of the slot allocated
+  *         by the device, reported in the scheduling trace
+  * \params allocationInfo the vector where the scheduling information is stored
+  */
+  void AllocateTransportBlock (mmwave::SfnSf timingInfo, uint8_t lcid, uint8_t symStart, uint8_t numSym,
+                               uint8_t mcs, uint32_t tbSize, Ptr<const MmWaveSidelinkRbMask> rbMask,
+                               double slotUtilization, std::vector<SlTtiAllocInfo>& allocationInfo);
 
   /**
   * \brief Updates the BSR corresponding to the specified LC by subtracting the
@@ -208,15 +541,57 @@ private:
   Ptr<mmwave::MmWaveAmc> m_amc; //!< pointer to AMC instance
   bool m_useAmc; //!< set to true to use adaptive modulation and coding
   uint8_t m_mcs; //!< the MCS used to transmit the packets if AMC is not used
+  uint32_t m_subChannelSize; //!< number of RBs per sub-channel, if 0 the transport blocks use all the RBs
+  Ptr<MmWaveSidelinkScheduler> m_scheduler; //!< the scheduler
+  Ptr<const MmWaveSidelinkTbSizeTable> m_tbSizeTable; //!< the table used by the scheduler to compute the TB sizes
+  bool m_txPowerControl; //!< set to true to use the closed-loop power control
+  double m_targetSinr; //!< the SINR targeted by the power control in dB
+  double m_minTxPower; //!< the minimum tx power in dBm
+  double m_maxTxPower; //!< the maximum tx power in dBm
+  double m_txPowerStep; //!< the step of the power control in dB
+  std::map<uint16_t, double> m_txPowerMap; //!< map containing the <RNTI, tx power> pairs
   uint16_t m_rnti; //!< radio network temporary identifier
   std::vector<uint16_t> m_sfAllocInfo; //!< defines the subframe allocation, m_sfAllocInfo[i] = RNTI of the device scheduled for slot i
-  std::map<uint16_t, std::list<LteMacSapProvider::TransmitPduParameters>> m_txBufferMap; //!< map containing the <RNTI, tx buffer> pairs
-  std::map<uint16_t, std::vector<int>> m_slCqiReported; //!< map containing the <RNTI, CQI> pairs
+  std::vector<SlTxQueue> m_txQueues; //!< the tx queues, indexed by the peer index
+  std::vector<uint32_t> m_peerIndexMap; //!< m_peerIndexMap[rnti] = peer index of the device with that RNTI
+  uint32_t m_txQueueCapacity; //!< the initial capacity of each tx queue in PDUs
+  uint32_t m_txQueueBytes; //!< the number of bytes in the tx queues
+  uint32_t m_txQueuePackets; //!< the number of PDUs in the tx queues
+  std::map<uint16_t, SlLinkQualityState> m_slCqiReported; //!< map containing the <RNTI, link quality> pairs
+  uint32_t m_cqiHistorySize; //!< the number of CQIs kept for each device
+  double m_cqiFilterWeight; //!< the weight of the latest CQI in the moving average
+  Time m_cqiExpirationTime; //!< the age after which the CQI is not used, if 0 it never expires
+  uint8_t m_fallbackMcs; //!< the MCS used when the CQI is not available
+  bool m_olla; //!< set to true to use the outer loop link adaptation
+  double m_targetBler; //!< the BLER targeted by the outer loop link adaptation
+  double m_ollaStepUp; //!< the increase of the SINR offset after a failed transport block in dB
+  double m_ollaMaxOffset; //!< the maximum absolute value of the SINR offset in dB
+  bool m_harq; //!< set to true to use HARQ
+  uint8_t m_numHarqProcesses; //!< the number of HARQ processes for each destination
+  uint8_t m_maxHarqRetx; //!< the maximum number of retransmissions of a transport block
+  std::map<uint16_t, std::vector<SlHarqProcess>> m_harqProcesses; //!< map containing the <RNTI, HARQ processes> pairs
+  std::list<std::pair<uint16_t, uint8_t>> m_harqRetxQueue; //!< the <RNTI, HARQ process ID> pairs waiting for retransmission
+  ResourceSelectionMode_t m_resourceSelection; //!< how the slots used by the device are selected
+  Time m_sensingWindow; //!< the time over which the sensed power is considered
+  double m_sensingThreshold; //!< the power above which a slot is considered busy in dBm
+  double m_minCandidateRatio; //!< the minimum fraction of slots which must be left as candidates
+  uint32_t m_numReservedSlots; //!< the number of slots reserved in each subframe
+  uint32_t m_minReselectionCounter; //!< the minimum initial value of the reselection counter
+  uint32_t m_maxReselectionCounter; //!< the maximum initial value of the reselection counter
+  double m_probResourceKeep; //!< the probability of keeping the reservation when the counter expires
+  std::deque<SlSensingRecord> m_sensingRecords; //!< the power sensed in the sensing window, from the oldest
+  std::vector<std::pair<uint16_t, Time>> m_sensedSlotOwner; //!< m_sensedSlotOwner[i] = <RNTI, time> of the last device which transmitted to this device in slot i
+  std::vector<uint8_t> m_reservedSlots; //!< the slots reserved by the device, sorted
+  uint32_t m_reselectionCounter; //!< the number of subframes before the reservation expires
+  Ptr<UniformRandomVariable> m_uniformRv; //!< random variable used for the resource selection
   Callback<void, Ptr<Packet> > m_forwardUpCallback; //!< upward callback to the NetDevice
   std::map<uint8_t, LteMacSapProvider::ReportBufferStatusParameters> m_bufferStatusReportMap; //!< map containing the <LCID, buffer status in bits> pairs
 
   // trace sources
   TracedCallback<SlSchedulingCallback> m_schedulingTrace; //!< trace source returning information regarding the scheduling
+  TracedCallback<uint16_t, double> m_txPowerTrace; //!< trace source returning the tx power selected by the power control
+  TracedCallback<uint16_t, double> m_sinrOffsetTrace; //!< trace source returning the SINR offset of the outer loop link adaptation
+  TracedCallback<uint16_t, uint8_t> m_resourceSelectionTrace; //!< trace source returning the slots selected by the sensing-based resource selection
 };
 
 class MacSidelinkMemberPhySapUser : public MmWaveSidelinkPhySapUser
@@ -229,7 +604,13 @@ public:
 
   void SlotIndication (mmwave::SfnSf timingInfo) override;
 
-  void SlSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize) override;
+  void SlSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report) override;
+
+  uint32_t GetSlotsUntilNextActivity (mmwave::SfnSf timingInfo) override;
+
+  void ReceiveFeedback (SlFeedbackInfo feedback) override;
+
+  void SlSensingReport (mmwave::SfnSf timingInfo, uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm) override;
 
 private:
   Ptr<MmWaveSidelinkMac> m_mac;
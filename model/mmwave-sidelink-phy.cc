@@ -19,11 +19,14 @@
 
 
 #include "mmwave-sidelink-phy.h"
+#include "mmwave-vehicular-net-device.h"
 #include <ns3/mmwave-spectrum-value-helper.h>
 #include <ns3/mmwave-mac-pdu-tag.h>
 #include <ns3/mmwave-mac-pdu-header.h>
 #include <ns3/double.h>
 #include <ns3/pointer.h>
+#include <ns3/boolean.h>
+#include <cmath>
 
 namespace ns3 {
 
@@ -36,7 +39,7 @@ MacSidelinkMemberPhySapProvider::MacSidelinkMemberPhySapProvider (Ptr<MmWaveSide
 }
 
 void
-MacSidelinkMemberPhySapProvider::AddTransportBlock (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info)
+MacSidelinkMemberPhySapProvider::AddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info)
 {
   m_phy->DoAddTransportBlock (pb, info);
 }
@@ -47,6 +50,18 @@ MacSidelinkMemberPhySapProvider::PrepareForReception (uint16_t rnti)
   m_phy->DoPrepareForReceptionFrom (rnti);
 }
 
+void
+MacSidelinkMemberPhySapProvider::NotifyTrafficPending ()
+{
+  m_phy->DoNotifyTrafficPending ();
+}
+
+void
+MacSidelinkMemberPhySapProvider::SendFeedback (uint16_t rnti, SlFeedbackInfo feedback)
+{
+  m_phy->DoSendFeedback (rnti, feedback);
+}
+
 //-----------------------------------------------------------------------
 
 NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkPhy");
@@ -60,20 +75,29 @@ MmWaveSidelinkPhy::MmWaveSidelinkPhy ()
 }
 
 MmWaveSidelinkPhy::MmWaveSidelinkPhy (Ptr<MmWaveSidelinkSpectrumPhy> spectrumPhy, Ptr<mmwave::MmWavePhyMacCommon> confParams)
+  : m_txPsdPower (0.0),
+    m_fastForward (false),
+    m_slotClockDriven (false)
 {
   NS_LOG_FUNCTION (this);
   m_sidelinkSpectrumPhy = spectrumPhy;
   m_phyMacConfig = confParams;
 
+  // use a private PSD cache, unless a shared one is set
+  m_psdCache = Create<MmWaveSidelinkPsdCache> (confParams);
+
   // create the PHY SAP provider
   m_phySapProvider = new MacSidelinkMemberPhySapProvider (this);
 
+  // each transport block occupies at least one symbol of the slot
+  m_phyBuffer.SetCapacity (m_phyMacConfig->GetSymbPerSlot ());
+
   // create the noise PSD
   Ptr<SpectrumValue> noisePsd = mmwave::MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
   m_sidelinkSpectrumPhy->SetNoisePowerSpectralDensity (noisePsd);
 
   // schedule the first slot
-  Simulator::ScheduleNow (&MmWaveSidelinkPhy::StartSlot, this, mmwave::SfnSf (0, 0, 0));
+  m_slotEvent = Simulator::ScheduleNow (&MmWaveSidelinkPhy::StartSlot, this, mmwave::SfnSf (0, 0, 0));
 }
 
 MmWaveSidelinkPhy::~MmWaveSidelinkPhy ()
@@ -104,7 +128,19 @@ MmWaveSidelinkPhy::GetTypeId (void)
                     DoubleValue (5.0),
                     MakeDoubleAccessor (&MmWaveSidelinkPhy::SetNoiseFigure,
                                         &MmWaveSidelinkPhy::GetNoiseFigure),
-                    MakeDoubleChecker<double> ());
+                    MakeDoubleChecker<double> ())
+    .AddAttribute ("SpectrumPhy",
+                   "The SpectrumPhy instance associated with this PHY",
+                   TypeId::ATTR_GET,
+                   PointerValue (),
+                   MakePointerAccessor (&MmWaveSidelinkPhy::m_sidelinkSpectrumPhy),
+                   MakePointerChecker<MmWaveSidelinkSpectrumPhy> ())
+    .AddAttribute ("FastForwardIdleSlots",
+                   "If true, the slots in which the MAC has nothing to do are skipped, "
+                   "and the next slot is started directly at the next slot of interest",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MmWaveSidelinkPhy::m_fastForward),
+                   MakeBooleanChecker ());
   return tid;
 }
 
@@ -125,6 +161,9 @@ void
 MmWaveSidelinkPhy::SetTxPower (double power)
 {
   m_txPower = power;
+
+  // the PSD will be retrieved again at the next transmission
+  m_txPsd = nullptr;
 }
 double
 MmWaveSidelinkPhy::GetTxPower () const
@@ -132,6 +171,22 @@ MmWaveSidelinkPhy::GetTxPower () const
   return m_txPower;
 }
 
+void
+MmWaveSidelinkPhy::SetPsdCache (Ptr<MmWaveSidelinkPsdCache> cache)
+{
+  NS_LOG_FUNCTION (this << cache);
+  NS_ASSERT_MSG (cache->GetConfigurationParameters () == m_phyMacConfig,
+                 "The PSD cache has to use the same configuration parameters");
+  m_psdCache = cache;
+  m_txPsd = nullptr;
+}
+
+Ptr<MmWaveSidelinkPsdCache>
+MmWaveSidelinkPhy::GetPsdCache () const
+{
+  return m_psdCache;
+}
+
 void
 MmWaveSidelinkPhy::SetNoiseFigure (double nf)
 {
@@ -175,13 +230,19 @@ MmWaveSidelinkPhy::SetPhySapUser (MmWaveSidelinkPhySapUser* sap)
 }
 
 void
-MmWaveSidelinkPhy::DoAddTransportBlock (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info)
+MmWaveSidelinkPhy::DoAddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info)
 {
-  // create a new entry for the PHY buffer
-  PhyBufferEntry e = std::make_pair (pb, info);
+  // with the FDM scheduling multiple TBs can share the same symbols, hence
+  // the buffer may have to be enlarged
+  if (m_phyBuffer.IsFull ())
+  {
+    uint32_t capacity = 2 * m_phyBuffer.GetCapacity ();
+    NS_LOG_LOGIC ("Enlarge the PHY buffer to " << capacity << " TBs");
+    m_phyBuffer.SetCapacity (capacity);
+  }
 
   // add the new entry to the buffer
-  m_phyBuffer.push_back (e);
+  m_phyBuffer.PushBack (std::make_pair (pb, info));
 }
 
 void
@@ -189,68 +250,113 @@ MmWaveSidelinkPhy::StartSlot (mmwave::SfnSf timingInfo)
 {
    NS_LOG_FUNCTION (this << " frame " << timingInfo.m_frameNum << " subframe " << timingInfo.m_sfNum << " slot " << timingInfo.m_slotNum);
 
+  m_lastSlotStart = Simulator::Now ();
+  m_lastTimingInfo = timingInfo;
+
   // trigger the MAC
   m_phySapUser->SlotIndication (timingInfo);
 
-  while (m_phyBuffer.size () != 0)
-  {
-    uint8_t usedSymbols = 0; // the symbol index
-
-    // retrieve the first element in the list
-    Ptr<PacketBurst> pktBurst;
-    mmwave::TtiAllocInfo info;
-    std::tie (pktBurst, info) = m_phyBuffer.front ();
+  // sort the transport blocks by their first symbol, keeping the order of the
+  // MAC for those starting together
+  m_phyBuffer.Sort ([] (const PhyBufferEntry& a, const PhyBufferEntry& b)
+                    {
+                      return a.second.m_dci.m_symStart < b.second.m_dci.m_symStart;
+                    });
 
-    // send the transport block
-    if (info.m_ttiType == mmwave::TtiAllocInfo::DATA)
-    {
-      usedSymbols += SlData (pktBurst, info);
-    }
-    else if (info.m_ttiType == mmwave::TtiAllocInfo::CTRL)
+  for (uint32_t i = 0; i < m_phyBuffer.GetSize (); i++)
+  {
+    const mmwave::TtiAllocInfo& info = m_phyBuffer[i].second;
+    if (info.m_ttiType == mmwave::TtiAllocInfo::CTRL)
     {
       NS_FATAL_ERROR ("Control messages are not currently supported");
     }
-    else
+    else if (info.m_ttiType != mmwave::TtiAllocInfo::DATA)
     {
       NS_FATAL_ERROR ("Unknown TB type");
     }
 
     // check if we exceeded the slot boundaries
-    NS_ASSERT_MSG (usedSymbols <= m_phyMacConfig->GetSymbPerSlot (), "Exceeded number of available symbols");
+    NS_ASSERT_MSG (info.m_dci.m_symStart + info.m_dci.m_numSym <= m_phyMacConfig->GetSymbPerSlot (), "Exceeded number of available symbols");
+  }
 
-    // remove the transport block from the buffer
-    m_phyBuffer.pop_front ();
+  // start the transmission of the transport blocks
+  if (!m_phyBuffer.IsEmpty ())
+  {
+    m_txEvent = Simulator::Schedule (GetTxStartTime (m_phyBuffer.Front ().second) - Simulator::Now (),
+                                     &MmWaveSidelinkPhy::SendTransportBlocks, this);
+  }
+
+  // the next slot will be started by the slot clock
+  if (m_slotClockDriven)
+  {
+    return;
+  }
+
+  // if the idle slots are skipped, ask the MAC for the next slot of interest
+  uint32_t slots = 1;
+  if (m_fastForward)
+  {
+    slots = m_phySapUser->GetSlotsUntilNextActivity (timingInfo);
+    NS_LOG_LOGIC ("Skip " << slots - 1 << " slots");
   }
 
   // update the timing information
-  timingInfo = UpdateTimingInfo (timingInfo);
-  Simulator::Schedule (m_phyMacConfig->GetSlotPeriod (), &MmWaveSidelinkPhy::StartSlot, this, timingInfo);
+  timingInfo = AdvanceTimingInfo (timingInfo, slots);
+  m_slotEvent = Simulator::Schedule (m_phyMacConfig->GetSlotPeriod () * slots, &MmWaveSidelinkPhy::StartSlot, this, timingInfo);
+}
+
+void
+MmWaveSidelinkPhy::SendTransportBlocks ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // send all the transport blocks starting in this symbol
+  while (!m_phyBuffer.IsEmpty () && GetTxStartTime (m_phyBuffer.Front ().second) <= Simulator::Now ())
+  {
+    Ptr<PacketBurst> pktBurst;
+    SlTtiAllocInfo info;
+    std::tie (pktBurst, info) = m_phyBuffer.Front ();
+    m_phyBuffer.PopFront ();
+
+    SlData (pktBurst, info);
+  }
+
+  // schedule the transmission of the next transport blocks
+  if (!m_phyBuffer.IsEmpty ())
+  {
+    m_txEvent = Simulator::Schedule (GetTxStartTime (m_phyBuffer.Front ().second) - Simulator::Now (),
+                                     &MmWaveSidelinkPhy::SendTransportBlocks, this);
+  }
+}
+
+Time
+MmWaveSidelinkPhy::GetTxStartTime (const mmwave::TtiAllocInfo& info) const
+{
+  // IndexOfTheFirstSymbol * SymbolDuration from the beginning of the slot
+  return m_lastSlotStart + info.m_dci.m_symStart * m_phyMacConfig->GetSymbolPeriod ();
 }
 
 uint8_t
-MmWaveSidelinkPhy::SlData (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info)
+MmWaveSidelinkPhy::SlData (Ptr<PacketBurst> pb, SlTtiAllocInfo info)
 {
   NS_LOG_FUNCTION (this);
 
-  // create the tx PSD
-  //TODO do we need to create a new psd at each TTI?
-  std::vector<int> subChannelsForTx = SetSubChannelsForTransmission ();
+  // if the MAC did not select the subchannels, use all the available ones
+  Ptr<const MmWaveSidelinkRbMask> subChannelsForTx = info.m_rbMask;
+  if (!subChannelsForTx)
+  {
+    subChannelsForTx = MmWaveSidelinkRbMask::GetFullMask (m_phyMacConfig->GetNumRb ());
+  }
 
-  // compute the tx start time (IndexOfTheFirstSymbol * SymbolDuration)
-  Time startTime = info.m_dci.m_symStart * m_phyMacConfig->GetSymbolPeriod ();
-  NS_ASSERT_MSG (startTime == info.m_dci.m_symStart * m_phyMacConfig->GetSymbolPeriod (), "startTime was not been correctly set");
+  // set the tx PSD, using the power selected by the MAC if any
+  double txPower = std::isnan (info.m_txPower) ? m_txPower : info.m_txPower;
+  SetSubChannelsForTransmission (subChannelsForTx, txPower);
 
   // compute the duration of the transmission (NumberOfSymbols * SymbolDuration)
   Time duration = info.m_dci.m_numSym * m_phyMacConfig->GetSymbolPeriod ();
 
-  NS_ASSERT_MSG (duration == info.m_dci.m_numSym * m_phyMacConfig->GetSymbolPeriod (), "duration was not been correctly set");
-
   // send the transport block
-  Simulator::Schedule (startTime, &MmWaveSidelinkPhy::SendDataChannels, this,
-                       pb,
-                       duration,
-                       info,
-                       subChannelsForTx);
+  SendDataChannels (pb, duration, info, subChannelsForTx);
 
   return info.m_dci.m_numSym;
 }
@@ -259,7 +365,7 @@ void
 MmWaveSidelinkPhy::SendDataChannels (Ptr<PacketBurst> pb,
   Time duration,
   mmwave::TtiAllocInfo info,
-  std::vector<int> rbBitmap)
+  Ptr<const MmWaveSidelinkRbMask> rbBitmap)
 {
   // retrieve the RNTI of the device we want to communicate with and properly
   // configure the beamforming
@@ -267,53 +373,40 @@ MmWaveSidelinkPhy::SendDataChannels (Ptr<PacketBurst> pb,
   NS_ASSERT_MSG (m_deviceMap.find (info.m_rnti) != m_deviceMap.end (), "Device not found");
   m_sidelinkSpectrumPhy->ConfigureBeamforming (m_deviceMap.at (info.m_rnti));
 
-  m_sidelinkSpectrumPhy->StartTxDataFrames (pb, duration, info.m_dci.m_mcs, info.m_dci.m_tbSize, info.m_dci.m_numSym, info.m_dci.m_rnti, info.m_rnti, rbBitmap);
+  m_sidelinkSpectrumPhy->StartTxDataFrames (pb, duration, info.m_dci.m_mcs, info.m_dci.m_tbSize, info.m_dci.m_numSym, info.m_dci.m_rnti, info.m_rnti, rbBitmap,
+                                             info.m_dci.m_harqProcess, info.m_dci.m_ndi, info.m_dci.m_rv);
 }
 
-std::vector<int>
-MmWaveSidelinkPhy::SetSubChannelsForTransmission ()
+void
+MmWaveSidelinkPhy::SetSubChannelsForTransmission (Ptr<const MmWaveSidelinkRbMask> rbs, double txPower)
+{
+  // retrieve the tx PSD from the cache and set it in the spectrum phy, if
+  // the tx power or the subchannels changed
+  if (!m_txPsd || m_txPsdRbs != rbs || m_txPsdPower != txPower)
   {
-    // create the transmission mask, use all the available subchannels
-    std::vector<int> subChannelsForTx (m_phyMacConfig->GetNumRb ());
-    for (uint32_t i = 0; i < subChannelsForTx.size (); i++)
-    {
-      subChannelsForTx.at(i) = i;
-    }
-
-    // create the tx PSD
-    Ptr<SpectrumValue> txPsd = mmwave::MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, m_txPower, subChannelsForTx);
-
-    // set the tx PSD in the spectrum phy
-    m_sidelinkSpectrumPhy->SetTxPowerSpectralDensity (txPsd);
-
-    return subChannelsForTx;
+    // the PSD spreads the power over the whole bandwidth and fills only
+    // the used RBs, hence the power per RB does not depend on the mask
+    m_txPsd = m_psdCache->GetTxPsd (txPower, rbs);
+    m_txPsdRbs = rbs;
+    m_txPsdPower = txPower;
+    m_sidelinkSpectrumPhy->SetTxPowerSpectralDensity (m_txPsd);
   }
+}
 
 mmwave::SfnSf
-MmWaveSidelinkPhy::UpdateTimingInfo (mmwave::SfnSf info) const
+MmWaveSidelinkPhy::AdvanceTimingInfo (mmwave::SfnSf info, uint32_t slots) const
 {
-  NS_LOG_INFO (this);
-
-  uint32_t nextSlot = info.m_slotNum + 1;
-  uint32_t nextSf = info.m_sfNum;
-  uint32_t nextFrame = info.m_frameNum;
-
-  if (nextSlot == m_phyMacConfig->GetSlotsPerSubframe ())
-  {
-    nextSlot = 0;
-    ++nextSf;
+  uint32_t slotsPerSf = m_phyMacConfig->GetSlotsPerSubframe ();
+  uint32_t sfPerFrame = m_phyMacConfig->GetSubframesPerFrame ();
 
-    if (nextSf == m_phyMacConfig->GetSubframesPerFrame ())
-    {
-      nextSf = 0;
-      ++nextFrame;
-    }
-  }
+  // compute the indexes without iterating over the skipped slots
+  uint32_t totSlots = info.m_slotNum + slots;
+  uint32_t totSf = info.m_sfNum + totSlots / slotsPerSf;
 
   // update the mmwave::SfnSf structure
-  info.m_slotNum = nextSlot;
-  info.m_sfNum = nextSf;
-  info.m_frameNum = nextFrame;
+  info.m_slotNum = totSlots % slotsPerSf;
+  info.m_sfNum = totSf % sfPerFrame;
+  info.m_frameNum = info.m_frameNum + totSf / sfPerFrame;
 
   return info;
 }
@@ -326,6 +419,59 @@ MmWaveSidelinkPhy::DoPrepareForReceptionFrom (uint16_t rnti)
   m_sidelinkSpectrumPhy->ConfigureBeamforming (m_deviceMap.at (rnti));
 }
 
+void
+MmWaveSidelinkPhy::AttachToSlotClock ()
+{
+  NS_LOG_FUNCTION (this);
+  m_slotEvent.Cancel ();
+  m_slotClockDriven = true;
+}
+
+void
+MmWaveSidelinkPhy::DoNotifyTrafficPending ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_fastForward || !m_slotEvent.IsRunning ())
+  {
+    return;
+  }
+
+  // find the first slot boundary after the current time
+  Time slotPeriod = m_phyMacConfig->GetSlotPeriod ();
+  uint32_t slots = (Simulator::Now () - m_lastSlotStart).GetInteger () / slotPeriod.GetInteger () + 1;
+  Time delay = m_lastSlotStart + slotPeriod * slots - Simulator::Now ();
+
+  // anticipate the next slot if it was scheduled later
+  if (delay < Simulator::GetDelayLeft (m_slotEvent))
+  {
+    NS_LOG_LOGIC ("Wake up in " << delay.GetSeconds () << " s");
+    m_slotEvent.Cancel ();
+    m_slotEvent = Simulator::Schedule (delay, &MmWaveSidelinkPhy::StartSlot, this, AdvanceTimingInfo (m_lastTimingInfo, slots));
+  }
+}
+
+void
+MmWaveSidelinkPhy::DoSendFeedback (uint16_t rnti, SlFeedbackInfo feedback)
+{
+  NS_LOG_FUNCTION (this << rnti);
+  NS_ASSERT_MSG (m_deviceMap.find (rnti) != m_deviceMap.end (), "Cannot find device with rnti " << rnti);
+
+  Ptr<MmWaveVehicularNetDevice> dev = DynamicCast<MmWaveVehicularNetDevice> (m_deviceMap.at (rnti));
+  NS_ASSERT_MSG (dev, "The feedback can be sent only to a MmWaveVehicularNetDevice");
+
+  // deliver the feedback in a new event, to avoid calling the MAC of the
+  // other device while it may be processing a slot
+  Simulator::ScheduleNow (&MmWaveSidelinkPhy::ReceiveFeedback, dev->GetPhy (), feedback);
+}
+
+void
+MmWaveSidelinkPhy::ReceiveFeedback (SlFeedbackInfo feedback)
+{
+  NS_LOG_FUNCTION (this << feedback.rnti);
+  m_phySapUser->ReceiveFeedback (feedback);
+}
+
 void
 MmWaveSidelinkPhy::AddDevice (uint64_t rnti, Ptr<NetDevice> dev)
 {
@@ -351,15 +497,23 @@ MmWaveSidelinkPhy::Receive (Ptr<Packet> p)
 }
 
 void
-MmWaveSidelinkPhy::GenerateSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize, uint8_t mcs)
+MmWaveSidelinkPhy::GenerateSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report)
 {
-  NS_LOG_FUNCTION (this << rnti << (uint32_t)numSym << tbSize << (uint32_t)mcs);
+  NS_LOG_FUNCTION (this << report.rnti << (uint32_t)report.numSym << report.tbSize << (uint32_t)report.mcs);
 
-  double sinrAvg = Sum (sinr) / (sinr.GetSpectrumModel ()->GetNumBands ());
-  NS_LOG_INFO ("Average SINR with dev " << rnti << " = " << 10 * std::log10 (sinrAvg));
+  NS_LOG_INFO ("Average SINR with dev " << report.rnti << " = " << report.sinr.meanDb);
+
+  // forward the report to the MAC layer
+  m_phySapUser->SlSinrReport (sinr, report);
+}
+
+void
+MmWaveSidelinkPhy::GenerateSensingReport (uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm)
+{
+  NS_LOG_FUNCTION (this << senderRnti << destinationRnti << rssiDbm);
 
   // forward the report to the MAC layer
-  m_phySapUser->SlSinrReport (sinr, rnti, numSym, tbSize);
+  m_phySapUser->SlSensingReport (m_lastTimingInfo, senderRnti, destinationRnti, rssiDbm);
 }
 
 } // namespace millicar
@@ -23,13 +23,18 @@
 
 #include "mmwave-sidelink-spectrum-phy.h"
 #include "mmwave-sidelink-sap.h"
+#include "mmwave-sidelink-psd-cache.h"
+#include "mmwave-sidelink-ring-buffer.h"
 
 namespace ns3 {
 
 namespace millicar {
 
+class MmWaveSidelinkSlotClock;
+
 class MmWaveSidelinkPhy : public Object
 {
+  friend class MmWaveSidelinkSlotClock;
 
 public:
 
@@ -70,6 +75,19 @@ public:
    */
   double GetTxPower () const;
 
+  /**
+   * Set the cache of the transmit PSDs. The same cache can be shared by all
+   * the PHYs using the same configuration parameters.
+   * \param cache the PSD cache
+   */
+  void SetPsdCache (Ptr<MmWaveSidelinkPsdCache> cache);
+
+  /**
+   * Returns the cache of the transmit PSDs
+   * \return the PSD cache
+   */
+  Ptr<MmWaveSidelinkPsdCache> GetPsdCache () const;
+
   /**
    * Set the noise figure
    * \param the noise figure in dB
@@ -120,9 +138,9 @@ public:
    * Add a transport block to the transmission buffer, which will be sent in the
    * current slot.
    * \param pb the packet burst containing the packets to be sent
-   * \param info the mmwave::TtiAllocInfo instance containg the transmission information
+   * \param info the SlTtiAllocInfo instance containg the transmission information
    */
-  void DoAddTransportBlock (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info);
+  void DoAddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info);
 
   /**
    * Prepare for the reception from another device by properly configuring
@@ -131,6 +149,27 @@ public:
    */
   void DoPrepareForReceptionFrom (uint16_t rnti);
 
+  /**
+   * Notify that new data is waiting to be transmitted. If the idle slots are
+   * skipped, the next slot is started at the next slot boundary.
+   */
+  void DoNotifyTrafficPending ();
+
+  /**
+   * Deliver a feedback to the PHY of another device, which forwards it to
+   * its MAC. The feedback path is ideal: the feedback is delivered without
+   * errors and without using the radio resources.
+   * \param rnti the RNTI of the destination device
+   * \param feedback the feedback
+   */
+  void DoSendFeedback (uint16_t rnti, SlFeedbackInfo feedback);
+
+  /**
+   * Receive a feedback sent by another device and forward it up to the MAC
+   * \param feedback the feedback
+   */
+  void ReceiveFeedback (SlFeedbackInfo feedback);
+
   /**
   * Receive the packet from SpectrumPhy and forward it up to the MAC
   * \param p received packet
@@ -142,36 +181,65 @@ public:
            It is hooked to the callback MmWaveSidelinkSpectrumPhy::m_slSinrReportCallback
   * \param sinr pointer to the SpectrumValue instance representing the SINR
             measured on all the spectrum chunks
-  * \param rnti the RNTI of the tranmitting device
-  * \param numSym size of the transport block that generated the report in
-            number of OFDM symbols
-  * \param tbSize size of the transport block that generated the report in bytes
-  * \param mcs the MCS of the transmission
+  * \param report information about the received transport block
   */
-  void GenerateSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize, uint8_t mcs);
+  void GenerateSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report);
+
+  /**
+  * \brief Forward to the MAC layer the received power of a sensed signal,
+           together with the timing information of the current slot.
+           It is hooked to the callback MmWaveSidelinkSpectrumPhy::m_slSensingCallback
+  * \param senderRnti the RNTI of the device which sent the signal
+  * \param destinationRnti the RNTI of the device to which the signal is destined
+  * \param rssiDbm the received power in dBm
+  */
+  void GenerateSensingReport (uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm);
 
 private:
 
   /**
-   * Start a slot. Send all the transport blocks in the buffer.
+   * Start a slot. Sort the transport blocks in the buffer by their first
+   * symbol and schedule the transmission of the first one.
    * \param timingInfo the structure containing the timing information
    */
   void StartSlot (mmwave::SfnSf timingInfo);
 
   /**
-   * Transmit a transport block
-   * \param pb the packet burst containing the packets to be sent
+   * Transmit all the transport blocks in the buffer which start in the
+   * current symbol, then schedule the transmission of the next ones
+   */
+  void SendTransportBlocks ();
+
+  /**
+   * Returns the time at which the transmission of a transport block in the
+   * current slot starts
    * \param info the mmwave::TtiAllocInfo instance containg the transmission information
+   * \return the start time
+   */
+  Time GetTxStartTime (const mmwave::TtiAllocInfo& info) const;
+
+  /**
+   * Stop scheduling the slots, which will be started by a
+   * MmWaveSidelinkSlotClock
+   */
+  void AttachToSlotClock ();
+
+  /**
+   * Transmit a transport block, starting from now
+   * \param pb the packet burst containing the packets to be sent
+   * \param info the SlTtiAllocInfo instance containg the transmission information
    * \return the number of symbols used to send this TB
    */
-  uint8_t SlData (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info);
+  uint8_t SlData (Ptr<PacketBurst> pb, SlTtiAllocInfo info);
 
   /**
-   * Set the transmission mask and creates the power spectral density for the
-   * transmission
-   * \return mask indicating the suchannels used for the transmission
+   * Set the power spectral density for a transmission on a set of RBs. The
+   * power per RB is the same as for a transmission over all the RBs, so that
+   * concurrent transmissions on different RBs do not exceed the tx power.
+   * \param rbs mask indicating the suchannels used for the transmission
+   * \param txPower the tx power of a transmission over all the RBs in dBm
    */
-  std::vector<int> SetSubChannelsForTransmission ();
+  void SetSubChannelsForTransmission (Ptr<const MmWaveSidelinkRbMask> rbs, double txPower);
 
   /**
    * Send the packet burts
@@ -181,19 +249,15 @@ private:
    * \param rbBitmap the mask indicating the suchannels to be used for the
             transmission
    */
-  void SendDataChannels (Ptr<PacketBurst> pb, Time duration, mmwave::TtiAllocInfo info, std::vector<int> rbBitmap);
+  void SendDataChannels (Ptr<PacketBurst> pb, Time duration, mmwave::TtiAllocInfo info, Ptr<const MmWaveSidelinkRbMask> rbBitmap);
 
   /**
-   * TODO: this can be done by overloading the operator ++ of the mmwave::SfnSf struct
-   * Update the mmwave::SfnSf structure to point to the next slot. If the current slot
-   * the last slot of the subframe, the next slot index will be 0 and the
-   * subframe index will be incremented. If the current subframe is the last
-   * subframe of the frame, the next subframe index will be 0 and the frame
-   * frame index will be incremented.
+   * Move the mmwave::SfnSf structure forward by a number of slots
    * \param info the mmwave::SfnSf structure containg frame, subframe and slot indeces
-   * \return the updated SnfSn structure pointing to the next slot
+   * \param slots the number of slots
+   * \return the updated SnfSn structure
    */
-  mmwave::SfnSf UpdateTimingInfo (mmwave::SfnSf info) const;
+  mmwave::SfnSf AdvanceTimingInfo (mmwave::SfnSf info, uint32_t slots) const;
 
   MmWaveSidelinkPhySapUser* m_phySapUser; //!< Sidelink PHY SAP user
   MmWaveSidelinkPhySapProvider* m_phySapProvider; //!< Sidelink PHY SAP provider
@@ -201,9 +265,20 @@ private:
   double m_noiseFigure; //!< the noise figure in dB
   Ptr<MmWaveSidelinkSpectrumPhy> m_sidelinkSpectrumPhy; //!< the SpectrumPhy instance associated with this PHY
   Ptr<mmwave::MmWavePhyMacCommon> m_phyMacConfig; //!< the configuration parameters
-  typedef std::pair<Ptr<PacketBurst>, mmwave::TtiAllocInfo> PhyBufferEntry; //!< type of the phy buffer entries
-  std::list<PhyBufferEntry> m_phyBuffer; //!< buffer of transport blocks to send in the current slot
+  typedef std::pair<Ptr<PacketBurst>, SlTtiAllocInfo> PhyBufferEntry; //!< type of the phy buffer entries
+  RingBuffer<PhyBufferEntry> m_phyBuffer; //!< buffer of transport blocks to send in the current slot
+  EventId m_txEvent; //!< the event of the next transmission in the current slot
   std::map<uint64_t, Ptr<NetDevice>> m_deviceMap; //!< map containing the <rnti, device> pairs of the nodes we want to communicate with
+  Ptr<MmWaveSidelinkPsdCache> m_psdCache; //!< the cache of the transmit PSDs
+  Ptr<SpectrumValue> m_txPsd; //!< the transmit PSD currently used by the SpectrumPhy
+  Ptr<const MmWaveSidelinkRbMask> m_txPsdRbs; //!< the resource blocks of m_txPsd
+  double m_txPsdPower; //!< the tx power of m_txPsd in dBm
+
+  bool m_fastForward; //!< if true, the slots in which the MAC has nothing to do are skipped
+  EventId m_slotEvent; //!< the event of the next StartSlot
+  Time m_lastSlotStart; //!< start time of the last slot
+  mmwave::SfnSf m_lastTimingInfo; //!< timing information of the last slot
+  bool m_slotClockDriven; //!< if true, the slots are started by a MmWaveSidelinkSlotClock
 };
 
 class MacSidelinkMemberPhySapProvider : public MmWaveSidelinkPhySapProvider
@@ -212,10 +287,14 @@ class MacSidelinkMemberPhySapProvider : public MmWaveSidelinkPhySapProvider
 public:
   MacSidelinkMemberPhySapProvider (Ptr<MmWaveSidelinkPhy> phy);
 
-  void AddTransportBlock (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info) override;
+  void AddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info) override;
 
   void PrepareForReception (uint16_t rnti) override;
 
+  void NotifyTrafficPending () override;
+
+  void SendFeedback (uint16_t rnti, SlFeedbackInfo feedback) override;
+
 private:
   Ptr<MmWaveSidelinkPhy> m_phy;
 
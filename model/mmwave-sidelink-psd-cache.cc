@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-psd-cache.h"
+#include <ns3/log.h>
+#include <ns3/mmwave-spectrum-value-helper.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkPsdCache");
+
+namespace millicar {
+
+MmWaveSidelinkPsdCache::MmWaveSidelinkPsdCache (Ptr<mmwave::MmWavePhyMacCommon> confParams, uint32_t maxSize)
+  : m_phyMacConfig (confParams),
+    m_maxSize (maxSize),
+    m_misses (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (maxSize > 0, "The cache must hold at least one PSD");
+}
+
+Ptr<mmwave::MmWavePhyMacCommon>
+MmWaveSidelinkPsdCache::GetConfigurationParameters () const
+{
+  return m_phyMacConfig;
+}
+
+Ptr<SpectrumValue>
+MmWaveSidelinkPsdCache::GetTxPsd (double txPower, Ptr<const MmWaveSidelinkRbMask> rbs)
+{
+  Key key = std::make_pair (txPower, PeekPointer (rbs));
+  auto it = m_psds.find (key);
+  if (it != m_psds.end ())
+    {
+      return it->second;
+    }
+
+  // with power control the number of power levels is not bounded, hence the
+  // cache is emptied when it becomes too large
+  if (m_psds.size () >= m_maxSize)
+    {
+      NS_LOG_LOGIC ("The cache is full, remove all the PSDs");
+      m_psds.clear ();
+    }
+
+  NS_LOG_LOGIC ("Create the PSD for tx power " << txPower << " dBm and " << rbs->GetNumRbs () << " RBs");
+  Ptr<SpectrumValue> psd = mmwave::MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, txPower, rbs->GetIndexes ());
+  m_psds.insert (std::make_pair (key, psd));
+  m_misses++;
+  return psd;
+}
+
+void
+MmWaveSidelinkPsdCache::Clear ()
+{
+  NS_LOG_FUNCTION (this);
+  m_psds.clear ();
+}
+
+uint32_t
+MmWaveSidelinkPsdCache::GetSize () const
+{
+  return m_psds.size ();
+}
+
+uint64_t
+MmWaveSidelinkPsdCache::GetMisses () const
+{
+  return m_misses;
+}
+
+} // namespace millicar
+
+} // namespace ns3
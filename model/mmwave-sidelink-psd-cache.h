@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_PSD_CACHE_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_PSD_CACHE_H_
+
+#include <map>
+#include <ns3/ptr.h>
+#include <ns3/simple-ref-count.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/mmwave-phy-mac-common.h>
+#include "mmwave-sidelink-rb-mask.h"
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkPsdCache
+ *
+ * Cache of the transmit power spectral densities, indexed by transmission
+ * power and set of resource blocks. A single instance can be shared by all
+ * the PHYs using the same mmwave::MmWavePhyMacCommon instance, so that each
+ * PSD is created once per simulation rather than once per transport block.
+ *
+ * The returned PSDs are shared with the other users of the cache and with the
+ * signals on the channel, hence they must not be modified. If the
+ * configuration parameters are changed, the cache has to be cleared.
+ */
+class MmWaveSidelinkPsdCache : public SimpleRefCount<MmWaveSidelinkPsdCache>
+{
+public:
+  /**
+   * Constructor
+   * \param confParams the configuration parameters used to create the PSDs
+   * \param maxSize the maximum number of PSDs kept in the cache
+   */
+  MmWaveSidelinkPsdCache (Ptr<mmwave::MmWavePhyMacCommon> confParams, uint32_t maxSize = 1024);
+
+  /**
+   * Returns the configuration parameters used to create the PSDs
+   * \return the mmwave::MmWavePhyMacCommon instance
+   */
+  Ptr<mmwave::MmWavePhyMacCommon> GetConfigurationParameters () const;
+
+  /**
+   * Returns the transmit PSD, creating it if it is not in the cache
+   * \param txPower the transmission power in dBm
+   * \param rbs the resource blocks used for the transmission
+   * \return the transmit PSD, which must not be modified
+   */
+  Ptr<SpectrumValue> GetTxPsd (double txPower, Ptr<const MmWaveSidelinkRbMask> rbs);
+
+  /**
+   * Remove all the PSDs, to be called when the configuration parameters
+   * change
+   */
+  void Clear ();
+
+  /**
+   * Returns the number of PSDs in the cache
+   * \return the number of PSDs
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * Returns the number of PSDs which have been created
+   * \return the number of cache misses
+   */
+  uint64_t GetMisses () const;
+
+private:
+  // since the masks are interned, the pointer identifies the set of RBs
+  typedef std::pair<double, const MmWaveSidelinkRbMask*> Key; //!< type of the cache keys
+
+  Ptr<mmwave::MmWavePhyMacCommon> m_phyMacConfig; //!< the configuration parameters
+  uint32_t m_maxSize; //!< maximum number of PSDs in the cache
+  std::map<Key, Ptr<SpectrumValue> > m_psds; //!< the cached PSDs
+  uint64_t m_misses; //!< number of PSDs which have been created
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_PSD_CACHE_H_ */
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-rb-mask.h"
+#include <unordered_map>
+#include <ns3/log.h>
+#include <ns3/abort.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkRbMask");
+
+namespace millicar {
+
+const uint32_t MmWaveSidelinkRbMask::MAX_RBS;
+
+MmWaveSidelinkRbMask::MmWaveSidelinkRbMask (const Bitset& bits)
+  : m_bits (bits)
+{
+  m_indexes.reserve (bits.count ());
+  for (uint32_t i = 0; i < MAX_RBS; i++)
+    {
+      if (bits.test (i))
+        {
+          m_indexes.push_back (i);
+        }
+    }
+}
+
+Ptr<const MmWaveSidelinkRbMask>
+MmWaveSidelinkRbMask::Get (const Bitset& bits)
+{
+  // the number of different masks used in a simulation is small, hence the
+  // instances are never released
+  static std::unordered_map<Bitset, Ptr<const MmWaveSidelinkRbMask> > masks;
+
+  auto it = masks.find (bits);
+  if (it == masks.end ())
+    {
+      NS_LOG_LOGIC ("Create a new RB mask with " << bits.count () << " RBs");
+      Ptr<const MmWaveSidelinkRbMask> mask = Ptr<const MmWaveSidelinkRbMask> (new MmWaveSidelinkRbMask (bits), false);
+      it = masks.insert (std::make_pair (bits, mask)).first;
+    }
+  return it->second;
+}
+
+Ptr<const MmWaveSidelinkRbMask>
+MmWaveSidelinkRbMask::FromIndexes (const std::vector<int>& rbs)
+{
+  Bitset bits;
+  for (int rb : rbs)
+    {
+      NS_ABORT_MSG_IF (rb < 0 || uint32_t (rb) >= MAX_RBS, "Invalid RB index " << rb);
+      bits.set (rb);
+    }
+  return Get (bits);
+}
+
+Ptr<const MmWaveSidelinkRbMask>
+MmWaveSidelinkRbMask::FromRange (uint32_t first, uint32_t numRb)
+{
+  NS_ABORT_MSG_IF (first + numRb > MAX_RBS, "At most " << MAX_RBS << " RBs are supported");
+  Bitset bits;
+  for (uint32_t i = first; i < first + numRb; i++)
+    {
+      bits.set (i);
+    }
+  return Get (bits);
+}
+
+Ptr<const MmWaveSidelinkRbMask>
+MmWaveSidelinkRbMask::GetFullMask (uint32_t numRb)
+{
+  return FromRange (0, numRb);
+}
+
+const MmWaveSidelinkRbMask::Bitset&
+MmWaveSidelinkRbMask::GetBits () const
+{
+  return m_bits;
+}
+
+const std::vector<int>&
+MmWaveSidelinkRbMask::GetIndexes () const
+{
+  return m_indexes;
+}
+
+uint32_t
+MmWaveSidelinkRbMask::GetNumRbs () const
+{
+  return m_indexes.size ();
+}
+
+bool
+MmWaveSidelinkRbMask::Overlaps (const MmWaveSidelinkRbMask& other) const
+{
+  return (m_bits & other.m_bits).any ();
+}
+
+} // namespace millicar
+
+} // namespace ns3
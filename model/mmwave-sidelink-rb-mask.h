@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RB_MASK_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RB_MASK_H_
+
+#include <bitset>
+#include <vector>
+#include <ns3/ptr.h>
+#include <ns3/simple-ref-count.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkRbMask
+ *
+ * Immutable set of resource blocks used by a transport block. The instances
+ * are interned, i.e., there is a single instance for each set of resource
+ * blocks, and are shared by pointer among the PHY, the SpectrumPhy, the
+ * signal parameters and the receivers, so that no per-RB data is copied when
+ * a transmission is delivered to multiple receivers.
+ */
+class MmWaveSidelinkRbMask : public SimpleRefCount<MmWaveSidelinkRbMask>
+{
+public:
+  static const uint32_t MAX_RBS = 275; //!< maximum number of resource blocks
+  typedef std::bitset<MAX_RBS> Bitset; //!< type used to store the mask
+
+  /**
+   * Returns the instance representing a set of resource blocks
+   * \param bits the resource blocks
+   * \return the shared instance
+   */
+  static Ptr<const MmWaveSidelinkRbMask> Get (const Bitset& bits);
+
+  /**
+   * Returns the instance representing a set of resource blocks
+   * \param rbs the indexes of the resource blocks
+   * \return the shared instance
+   */
+  static Ptr<const MmWaveSidelinkRbMask> FromIndexes (const std::vector<int>& rbs);
+
+  /**
+   * Returns the instance representing a range of contiguous resource blocks
+   * \param first the index of the first resource block
+   * \param numRb the number of resource blocks
+   * \return the shared instance
+   */
+  static Ptr<const MmWaveSidelinkRbMask> FromRange (uint32_t first, uint32_t numRb);
+
+  /**
+   * Returns the instance representing the first numRb resource blocks
+   * \param numRb the number of resource blocks
+   * \return the shared instance
+   */
+  static Ptr<const MmWaveSidelinkRbMask> GetFullMask (uint32_t numRb);
+
+  /**
+   * Returns the resource blocks as a bitset
+   * \return the bitset
+   */
+  const Bitset& GetBits () const;
+
+  /**
+   * Returns the indexes of the resource blocks in increasing order, as
+   * required by the mmwave spectrum helpers and error models
+   * \return the indexes of the resource blocks
+   */
+  const std::vector<int>& GetIndexes () const;
+
+  /**
+   * Returns the number of resource blocks in the mask
+   * \return the number of resource blocks
+   */
+  uint32_t GetNumRbs () const;
+
+  /**
+   * Check if the mask shares at least a resource block with another one
+   * \param other the other mask
+   * \return true if the two masks overlap
+   */
+  bool Overlaps (const MmWaveSidelinkRbMask& other) const;
+
+private:
+  /**
+   * Constructor, use Get to obtain an instance
+   * \param bits the resource blocks
+   */
+  explicit MmWaveSidelinkRbMask (const Bitset& bits);
+
+  Bitset m_bits; //!< the resource blocks
+  std::vector<int> m_indexes; //!< the indexes of the resource blocks
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RB_MASK_H_ */
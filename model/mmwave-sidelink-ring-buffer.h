@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RING_BUFFER_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RING_BUFFER_H_
+
+#include <vector>
+#include <utility>
+#include <ns3/assert.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * \class RingBuffer
+ *
+ * FIFO queue with a fixed capacity, stored in a contiguous array which is
+ * allocated once. Pushing an element when the buffer is full is an error.
+ */
+template <class T>
+class RingBuffer
+{
+public:
+  /**
+   * Constructor
+   * \param capacity the maximum number of elements, it must be positive
+   */
+  explicit RingBuffer (uint32_t capacity = 1)
+    : m_elements (capacity),
+      m_head (0),
+      m_size (0)
+  {
+    NS_ASSERT_MSG (capacity > 0, "The capacity must be positive");
+  }
+
+  /**
+   * Change the capacity of the buffer, keeping the stored elements
+   * \param capacity the maximum number of elements, it must be positive
+   */
+  void SetCapacity (uint32_t capacity)
+  {
+    NS_ASSERT_MSG (capacity > 0, "The capacity must be positive");
+    NS_ASSERT_MSG (capacity >= m_size, "The capacity can not be smaller than the number of elements");
+    std::vector<T> elements (capacity);
+    for (uint32_t i = 0; i < m_size; i++)
+      {
+        elements[i] = (*this)[i];
+      }
+    m_elements.swap (elements);
+    m_head = 0;
+  }
+
+  /**
+   * Returns the maximum number of elements
+   * \return the capacity of the buffer
+   */
+  uint32_t GetCapacity () const
+  {
+    return m_elements.size ();
+  }
+
+  /**
+   * Returns the number of elements in the buffer
+   * \return the number of elements
+   */
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+
+  /**
+   * Check if the buffer is empty
+   * \return true if the buffer is empty
+   */
+  bool IsEmpty () const
+  {
+    return m_size == 0;
+  }
+
+  /**
+   * Check if the buffer is full
+   * \return true if the buffer is full
+   */
+  bool IsFull () const
+  {
+    return m_size == m_elements.size ();
+  }
+
+  /**
+   * Add an element at the end of the buffer
+   * \param e the element
+   */
+  void PushBack (const T& e)
+  {
+    NS_ASSERT_MSG (!IsFull (), "The buffer is full");
+    m_elements[Index (m_size)] = e;
+    m_size++;
+  }
+
+  /**
+   * Returns the first element of the buffer
+   * \return a reference to the first element
+   */
+  T& Front ()
+  {
+    NS_ASSERT_MSG (!IsEmpty (), "The buffer is empty");
+    return m_elements[m_head];
+  }
+
+  /**
+   * Remove the first element of the buffer
+   */
+  void PopFront ()
+  {
+    NS_ASSERT_MSG (!IsEmpty (), "The buffer is empty");
+    m_elements[m_head] = T (); // release the resources held by the element
+    m_head = Index (1);
+    m_size--;
+  }
+
+  /**
+   * Returns the i-th element of the buffer, starting from the first
+   * \param i the index of the element
+   * \return a reference to the element
+   */
+  T& operator[] (uint32_t i)
+  {
+    NS_ASSERT_MSG (i < m_size, "Index out of range");
+    return m_elements[Index (i)];
+  }
+
+  /**
+   * Returns the i-th element of the buffer, starting from the first
+   * \param i the index of the element
+   * \return a const reference to the element
+   */
+  const T& operator[] (uint32_t i) const
+  {
+    NS_ASSERT_MSG (i < m_size, "Index out of range");
+    return m_elements[Index (i)];
+  }
+
+  /**
+   * Remove all the elements
+   */
+  void Clear ()
+  {
+    while (!IsEmpty ())
+      {
+        PopFront ();
+      }
+    m_head = 0;
+  }
+
+  /**
+   * Sort the elements with a stable insertion sort, which is the fastest
+   * option for the few elements stored in the buffer and preserves the
+   * insertion order of equivalent elements
+   * \param comp function returning true if the first argument has to be
+   *        placed before the second one
+   */
+  template <class Compare>
+  void Sort (Compare comp)
+  {
+    for (uint32_t i = 1; i < m_size; i++)
+      {
+        for (uint32_t j = i; j > 0 && comp ((*this)[j], (*this)[j - 1]); j--)
+          {
+            std::swap ((*this)[j], (*this)[j - 1]);
+          }
+      }
+  }
+
+private:
+  /**
+   * Returns the position in the array of the i-th element
+   * \param i the index of the element, starting from the first
+   * \return the position in the array
+   */
+  uint32_t Index (uint32_t i) const
+  {
+    return (m_head + i) % m_elements.size ();
+  }
+
+  std::vector<T> m_elements; //!< the array storing the elements
+  uint32_t m_head; //!< position of the first element
+  uint32_t m_size; //!< number of elements
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_RING_BUFFER_H_ */
@@ -25,11 +25,52 @@
 #include <ns3/lte-rlc-am.h>
 #include <ns3/spectrum-value.h>
 #include <ns3/mmwave-phy-mac-common.h>
+#include "mmwave-sidelink-sinr-summary.h"
+#include "mmwave-sidelink-rb-mask.h"
+#include <limits>
 
 namespace ns3 {
 
 namespace millicar {
 
+/**
+ * Information about the reception of a transport block, reported by the
+ * MmWaveSidelinkSpectrumPhy at the end of each reception
+ */
+struct SlSinrReportInfo
+{
+  uint16_t rnti; //!< RNTI of the transmitting device
+  uint8_t numSym; //!< number of OFDM symbols used by the transport block
+  uint32_t tbSize; //!< size of the transport block in bytes
+  uint8_t mcs; //!< MCS of the transport block
+  SinrSummary sinr; //!< statistics of the SINR over the RBs of the transport block
+  double tbler; //!< TB error rate returned by the error model
+  bool corrupt; //!< true if the transport block has been corrupted
+  uint8_t harqId; //!< HARQ process ID of the transport block
+};
+
+/**
+ * Scheduling decision for a transport block, i.e., the mmwave::TtiAllocInfo
+ * extended with the resource blocks used for the transmission
+ */
+struct SlTtiAllocInfo : public mmwave::TtiAllocInfo
+{
+  Ptr<const MmWaveSidelinkRbMask> m_rbMask; //!< the RBs used for the transmission, if null all the RBs are used
+  double m_txPower {std::numeric_limits<double>::quiet_NaN ()}; //!< the tx power in dBm, if NaN the tx power of the PHY is used
+};
+
+/**
+ * Feedback sent by the receiver of a transport block to its transmitter
+ * through the ideal sidelink feedback path
+ */
+struct SlFeedbackInfo
+{
+  uint16_t rnti; //!< RNTI of the device which received the transport block
+  double sinrDb; //!< average SINR of the transport block in dB
+  bool ack; //!< true if the transport block has been decoded correctly
+  uint8_t harqId; //!< HARQ process ID of the transport block
+};
+
 class MmWaveSidelinkPhySapProvider
 {
 public:
@@ -42,7 +83,7 @@ public:
    * \param pb burst of packets to be forwarded to the PHY layer
    * \param info information about slot allocation necessary to determine the transmission parameters
    */
-  virtual void AddTransportBlock (Ptr<PacketBurst> pb, mmwave::TtiAllocInfo info) = 0;
+  virtual void AddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info) = 0;
 
   /**
    * \brief Called by the upper layer to prepare the PHY for the reception from
@@ -51,6 +92,22 @@ public:
    */
   virtual void PrepareForReception (uint16_t rnti) = 0;
 
+  /**
+   * \brief Called by the upper layer to notify the PHY that new data is
+   *        waiting to be transmitted. If the PHY is skipping the idle slots,
+   *        it has to wake up at the next slot boundary.
+   */
+  virtual void NotifyTrafficPending () = 0;
+
+  /**
+   * \brief Called by the upper layer to send a feedback to another device.
+   *        The feedback is delivered through an ideal path, i.e., without
+   *        errors and without using the radio resources.
+   * \param rnti the RNTI of the destination device
+   * \param feedback the feedback
+   */
+  virtual void SendFeedback (uint16_t rnti, SlFeedbackInfo feedback) = 0;
+
 };
 
 class MmWaveSidelinkPhySapUser
@@ -75,13 +132,39 @@ public:
   /**
    * \brief Reports the SINR meausured with a certain device
    * \param sinr the SINR
-   * \param rnti RNTI of the transmitting device
-   * \param numSym size of the transport block that generated the report in
-            number of OFDM symbols
-   * \param tbSize size of the transport block that generated the report in
-            number of bytes
+   * \param report information about the received transport block, including
+   *        the statistics of the SINR and the outcome of the decoding
+   */
+  virtual void SlSinrReport (const SpectrumValue& sinr, const SlSinrReportInfo& report) = 0;
+
+  /**
+   * \brief Returns the number of slots between the current slot and the next
+   *        slot in which the MAC has something to do, i.e., a slot assigned to
+   *        this device when data is waiting to be transmitted, or a slot
+   *        assigned to another device which may transmit
+   * \param timingInfo the structure containing the timing information of the
+   *        current slot
+   * \return the number of slots, at least 1 and at most the number of slots
+   *         per subframe
+   */
+  virtual uint32_t GetSlotsUntilNextActivity (mmwave::SfnSf timingInfo) = 0;
+
+  /**
+   * \brief Called by the PHY to deliver the feedback sent by another device
+   * \param feedback the feedback
+   */
+  virtual void ReceiveFeedback (SlFeedbackInfo feedback) = 0;
+
+  /**
+   * \brief Reports a sidelink signal sensed by the device, either destined
+   *        to it or to another device
+   * \param timingInfo the structure containing the timing information of the
+   *        slot in which the signal was sensed
+   * \param senderRnti the RNTI of the device which sent the signal
+   * \param destinationRnti the RNTI of the device to which the signal is destined
+   * \param rssiDbm the received power in dBm
    */
-  virtual void SlSinrReport (const SpectrumValue& sinr, uint16_t rnti, uint8_t numSym, uint32_t tbSize) = 0;
+  virtual void SlSensingReport (mmwave::SfnSf timingInfo, uint16_t senderRnti, uint16_t destinationRnti, double rssiDbm) = 0;
 
 };
 
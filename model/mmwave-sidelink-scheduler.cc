@@ -0,0 +1,551 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-scheduler.h"
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkScheduler");
+
+namespace millicar {
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkScheduler);
+
+TypeId
+MmWaveSidelinkScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkScheduler")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+MmWaveSidelinkScheduler::MmWaveSidelinkScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkScheduler::~MmWaveSidelinkScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MmWaveSidelinkScheduler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_phyMacConfig = nullptr;
+  m_tbSizeTable = nullptr;
+  Object::DoDispose ();
+}
+
+void
+MmWaveSidelinkScheduler::SetConfiguration (Ptr<mmwave::MmWavePhyMacCommon> pmc, Ptr<const MmWaveSidelinkTbSizeTable> tbSizeTable)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!tbSizeTable || tbSizeTable->GetConfigurationParameters () == pmc,
+                 "The TB size table was built with different configuration parameters");
+  m_phyMacConfig = pmc;
+  m_tbSizeTable = tbSizeTable;
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkScheduler::Schedule (const SlSchedulerParams& params)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_phyMacConfig && m_tbSizeTable, "First set the configuration");
+
+  std::vector<SlSchedulerLcInfo> lcs = params.lcs;
+  SortLogicalChannels (params, lcs);
+
+  // if the sub-channels are used, allocate the resources also in frequency
+  if (params.subChannelSize > 0)
+  {
+    return ScheduleSubChannels (params, lcs);
+  }
+  return ScheduleSymbols (params, lcs);
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkScheduler::ScheduleSymbols (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<SlSchedulerGrant> grants;
+  uint32_t numRbs = m_phyMacConfig->GetNumRb ();
+  uint32_t availableSymbols = params.availableSymbols;
+  uint8_t symStart = 0; // indicates the next available symbol in the slot
+
+  // serve each logical channel with all the symbols it needs, until the
+  // slot is full
+  for (auto lcIt = lcs.begin (); lcIt != lcs.end () && availableSymbols > 0; lcIt++)
+  {
+    uint32_t assignedBytes = std::min (lcIt->requiredBytes, CalculateTbSize (lcIt->mcs, availableSymbols, numRbs));
+    if (assignedBytes == 0)
+    {
+      continue;
+    }
+
+    uint8_t numSym = GetMinNumSymForTbSize (assignedBytes, lcIt->mcs, numRbs, availableSymbols);
+    grants.push_back (SlSchedulerGrant {lcIt->lcid, symStart, numSym, lcIt->mcs, assignedBytes, nullptr});
+
+    lcIt->requiredBytes -= assignedBytes;
+    availableSymbols -= numSym;
+    symStart += numSym;
+  }
+  return grants;
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkScheduler::ScheduleSubChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<SlSchedulerGrant> grants;
+
+  // the last sub-channel may be smaller than the others
+  uint32_t numRb = m_phyMacConfig->GetNumRb ();
+  uint32_t numSubChannels = (numRb + params.subChannelSize - 1) / params.subChannelSize;
+
+  uint32_t availableSymbols = params.availableSymbols;
+  uint8_t symStart = 0; // indicates the next available symbol in the slot
+  uint32_t next = 0; // index of the next logical channel to serve
+
+  while (availableSymbols > 0 && lcs.size () > 0)
+  {
+    // select the logical channels served in this round, at most one per
+    // sub-channel
+    uint32_t numLcs = std::min<uint32_t> (lcs.size (), numSubChannels);
+    std::vector<uint32_t> selected;
+    for (uint32_t i = 0; i < numLcs; i++)
+    {
+      selected.push_back ((next + i) % lcs.size ());
+    }
+
+    // split the sub-channels among the selected logical channels, the first
+    // ones get the remaining sub-channels. If the share of a logical channel
+    // is too small to carry any data, the logical channel is not served in
+    // this round and the sub-channels are split again among the others, so
+    // that no sub-channel is left idle
+    std::vector<Ptr<const MmWaveSidelinkRbMask> > masks;
+    uint8_t numSym = 1;
+    bool split = false;
+    while (!split)
+    {
+      masks.clear ();
+      numSym = 1;
+      uint32_t firstSubChannel = 0;
+      for (uint32_t i = 0; i < numLcs; i++)
+      {
+        uint32_t subChannels = numSubChannels / numLcs + (i < numSubChannels % numLcs ? 1 : 0);
+        uint32_t rbStart = firstSubChannel * params.subChannelSize;
+        uint32_t numRbs = std::min (numRb, (firstSubChannel + subChannels) * params.subChannelSize) - rbStart;
+        firstSubChannel += subChannels;
+        masks.push_back (MmWaveSidelinkRbMask::FromRange (rbStart, numRbs));
+
+        // the duration of the round is given by the logical channel which
+        // needs more symbols
+        const SlSchedulerLcInfo& lc = lcs [selected [i]];
+        numSym = std::max (numSym, GetMinNumSymForTbSize (lc.requiredBytes, lc.mcs, numRbs, availableSymbols));
+      }
+
+      split = true;
+      for (uint32_t i = 0; i < numLcs && numLcs > 1; i++)
+      {
+        const SlSchedulerLcInfo& lc = lcs [selected [i]];
+        if (CalculateTbSize (lc.mcs, numSym, masks [i]->GetNumRbs ()) == 0)
+        {
+          NS_LOG_DEBUG ("Sub-channels too small for LCID " << uint16_t (lc.lcid) << ", split them again");
+          selected.erase (selected.begin () + i);
+          numLcs--;
+          split = false;
+          break;
+        }
+      }
+    }
+
+    NS_LOG_DEBUG ("Serve " << numLcs << " LCs in symbols [" << uint16_t (symStart) << ", " << uint16_t (symStart + numSym) << ")");
+
+    for (uint32_t i = 0; i < numLcs; i++)
+    {
+      SlSchedulerLcInfo& lc = lcs [selected [i]];
+      uint32_t assignedBytes = std::min (lc.requiredBytes, CalculateTbSize (lc.mcs, numSym, masks [i]->GetNumRbs ()));
+
+      // a logical channel served alone may still be unable to carry any
+      // data on all the sub-channels
+      if (assignedBytes == 0)
+      {
+        continue;
+      }
+
+      grants.push_back (SlSchedulerGrant {lc.lcid, symStart, numSym, lc.mcs, assignedBytes, masks [i]});
+      lc.requiredBytes -= assignedBytes;
+    }
+
+    // update the number of available symbols and the index of the next
+    // available symbol
+    availableSymbols -= numSym;
+    symStart += numSym;
+
+    // restart from the logical channel following the last one served,
+    // after removing those which do not need further resources
+    uint32_t last = selected.back ();
+    uint32_t removedBefore = std::count_if (lcs.begin (), lcs.begin () + last + 1,
+                                            [] (const SlSchedulerLcInfo& lc) { return lc.requiredBytes == 0; });
+    lcs.erase (std::remove_if (lcs.begin (), lcs.end (),
+                               [] (const SlSchedulerLcInfo& lc) { return lc.requiredBytes == 0; }),
+               lcs.end ());
+    next = last + 1 - removedBefore;
+    if (next >= lcs.size ())
+    {
+      next = 0;
+    }
+  }
+  return grants;
+}
+
+uint32_t
+MmWaveSidelinkScheduler::CalculateTbSize (uint8_t mcs, uint8_t numSym, uint32_t numRbs) const
+{
+  return m_tbSizeTable->GetTbSize (mcs, numSym, numRbs);
+}
+
+uint8_t
+MmWaveSidelinkScheduler::GetMinNumSymForTbSize (uint32_t tbSize, uint8_t mcs, uint32_t numRbs, uint8_t maxSym) const
+{
+  return m_tbSizeTable->GetMinNumSym (tbSize, mcs, numRbs, maxSym);
+}
+
+//-----------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkRrScheduler);
+
+TypeId
+MmWaveSidelinkRrScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkRrScheduler")
+    .SetParent<MmWaveSidelinkScheduler> ()
+    .AddConstructor<MmWaveSidelinkRrScheduler> ()
+  ;
+  return tid;
+}
+
+MmWaveSidelinkRrScheduler::MmWaveSidelinkRrScheduler ()
+  : m_lastLcid (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkRrScheduler::~MmWaveSidelinkRrScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkRrScheduler::Schedule (const SlSchedulerParams& params)
+{
+  std::vector<SlSchedulerGrant> grants = MmWaveSidelinkScheduler::Schedule (params);
+
+  // the next slot will start from the logical channel following the last
+  // one served. If the sub-channels are not used, m_lastLcid is updated by
+  // ScheduleSymbols
+  if (params.subChannelSize > 0 && !grants.empty ())
+  {
+    m_lastLcid = grants.back ().lcid;
+  }
+  return grants;
+}
+
+void
+MmWaveSidelinkRrScheduler::SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  // the logical channels are sorted by LCID, start from the first one after
+  // the last served
+  auto first = std::find_if (lcs.begin (), lcs.end (),
+                             [this] (const SlSchedulerLcInfo& lc) { return lc.lcid > m_lastLcid; });
+  std::rotate (lcs.begin (), first, lcs.end ());
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkRrScheduler::ScheduleSymbols (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<SlSchedulerGrant> grants;
+  uint32_t numRbs = m_phyMacConfig->GetNumRb ();
+  uint32_t availableSymbols = params.availableSymbols;
+
+  // compute the number of symbols each logical channel needs to empty its
+  // queues, at most all the available symbols
+  std::vector<uint32_t> demand (lcs.size ());
+  std::vector<uint32_t> assignedSymbols (lcs.size (), 0);
+  for (uint32_t i = 0; i < lcs.size (); i++)
+  {
+    demand [i] = lcs [i].requiredBytes > 0 ? GetMinNumSymForTbSize (lcs [i].requiredBytes, lcs [i].mcs, numRbs, availableSymbols) : 0;
+  }
+
+  // max-min fair allocation: visit the logical channels in increasing order
+  // of demand, each receives its demand as long as it does not exceed an
+  // equal share of the symbols left, so that the symbols not needed by the
+  // smaller demands are redistributed to the larger ones. The logical
+  // channels which need more than the share all receive the share
+  std::vector<uint32_t> order (lcs.size ());
+  for (uint32_t i = 0; i < order.size (); i++)
+  {
+    order [i] = i;
+  }
+  std::stable_sort (order.begin (), order.end (),
+                    [&demand] (uint32_t a, uint32_t b) { return demand [a] < demand [b]; });
+
+  uint32_t remainingSymbols = availableSymbols;
+  for (uint32_t k = 0; k < order.size (); k++)
+  {
+    uint32_t share = remainingSymbols / (order.size () - k);
+    if (demand [order [k]] > share)
+    {
+      for (uint32_t h = k; h < order.size (); h++)
+      {
+        assignedSymbols [order [h]] = share;
+      }
+      remainingSymbols -= share * (order.size () - k);
+      break;
+    }
+    assignedSymbols [order [k]] = demand [order [k]];
+    remainingSymbols -= demand [order [k]];
+  }
+
+  // the symbols left by the integer division are given one at a time to the
+  // logical channels which are still backlogged, in round robin order. Each
+  // pass assigns at least one symbol or stops, hence the loop terminates
+  bool assigned = true;
+  bool extraAssigned = false;
+  while (remainingSymbols > 0 && assigned)
+  {
+    assigned = false;
+    for (uint32_t i = 0; i < lcs.size () && remainingSymbols > 0; i++)
+    {
+      if (assignedSymbols [i] < demand [i])
+      {
+        assignedSymbols [i]++;
+        remainingSymbols--;
+        assigned = true;
+
+        // the next slot will start from the logical channel following the
+        // last one which received an additional symbol
+        m_lastLcid = lcs [i].lcid;
+        extraAssigned = true;
+      }
+    }
+  }
+
+  NS_LOG_DEBUG ("Allocated " << availableSymbols - remainingSymbols << " of " << availableSymbols << " symbols");
+
+  // create the grants, in round robin order
+  uint8_t symStart = 0; // indicates the next available symbol in the slot
+  for (uint32_t i = 0; i < lcs.size (); i++)
+  {
+    if (assignedSymbols [i] == 0)
+    {
+      continue;
+    }
+
+    uint32_t assignedBytes = std::min (lcs [i].requiredBytes, CalculateTbSize (lcs [i].mcs, assignedSymbols [i], numRbs));
+    if (assignedBytes == 0)
+    {
+      continue;
+    }
+    NS_LOG_DEBUG ("rnti " << lcs [i].rnti << " mcs = " << uint16_t (lcs [i].mcs) << " symbols = " << assignedSymbols [i]);
+    grants.push_back (SlSchedulerGrant {lcs [i].lcid, symStart, uint8_t (assignedSymbols [i]), lcs [i].mcs, assignedBytes, nullptr});
+    lcs [i].requiredBytes -= assignedBytes;
+    symStart += assignedSymbols [i];
+  }
+
+  // if no additional symbol was assigned, start from the logical channel
+  // following the last one served
+  if (!extraAssigned && !grants.empty ())
+  {
+    m_lastLcid = grants.back ().lcid;
+  }
+  return grants;
+}
+
+//-----------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkPfScheduler);
+
+TypeId
+MmWaveSidelinkPfScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkPfScheduler")
+    .SetParent<MmWaveSidelinkScheduler> ()
+    .AddConstructor<MmWaveSidelinkPfScheduler> ()
+    .AddAttribute ("TimeWindow",
+                   "Time window of the average throughput, in number of slots assigned "
+                   "to the device.",
+                   DoubleValue (100.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkPfScheduler::m_timeWindow),
+                   MakeDoubleChecker<double> (1.0))
+  ;
+  return tid;
+}
+
+MmWaveSidelinkPfScheduler::MmWaveSidelinkPfScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkPfScheduler::~MmWaveSidelinkPfScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+std::vector<SlSchedulerGrant>
+MmWaveSidelinkPfScheduler::Schedule (const SlSchedulerParams& params)
+{
+  std::vector<SlSchedulerGrant> grants = MmWaveSidelinkScheduler::Schedule (params);
+
+  // update the average throughput of all the logical channels, including
+  // those which have not been served
+  std::map<uint8_t, uint32_t> servedBytes;
+  for (const SlSchedulerGrant& grant : grants)
+  {
+    servedBytes [grant.lcid] += grant.tbSize;
+  }
+  for (const SlSchedulerLcInfo& lc : params.lcs)
+  {
+    m_avgThroughput.insert (std::make_pair (lc.lcid, 0.0));
+  }
+  for (auto& avg : m_avgThroughput)
+  {
+    auto served = servedBytes.find (avg.first);
+    double bytes = served != servedBytes.end () ? served->second : 0.0;
+    avg.second = (1.0 - 1.0 / m_timeWindow) * avg.second + bytes / m_timeWindow;
+  }
+  return grants;
+}
+
+void
+MmWaveSidelinkPfScheduler::SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  // compute the metric of each logical channel, i.e., the bytes it could
+  // send using the whole slot over its average throughput
+  uint32_t numRbs = m_phyMacConfig->GetNumRb ();
+  std::map<uint8_t, double> metric;
+  for (const SlSchedulerLcInfo& lc : lcs)
+  {
+    auto avg = m_avgThroughput.find (lc.lcid);
+    double avgThroughput = avg != m_avgThroughput.end () ? std::max (avg->second, 1.0) : 1.0;
+    metric [lc.lcid] = CalculateTbSize (lc.mcs, params.availableSymbols, numRbs) / avgThroughput;
+  }
+
+  std::stable_sort (lcs.begin (), lcs.end (),
+                    [&metric] (const SlSchedulerLcInfo& a, const SlSchedulerLcInfo& b)
+                    {
+                      return metric.at (a.lcid) > metric.at (b.lcid);
+                    });
+}
+
+//-----------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkMaxRateScheduler);
+
+TypeId
+MmWaveSidelinkMaxRateScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkMaxRateScheduler")
+    .SetParent<MmWaveSidelinkScheduler> ()
+    .AddConstructor<MmWaveSidelinkMaxRateScheduler> ()
+  ;
+  return tid;
+}
+
+MmWaveSidelinkMaxRateScheduler::MmWaveSidelinkMaxRateScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkMaxRateScheduler::~MmWaveSidelinkMaxRateScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MmWaveSidelinkMaxRateScheduler::SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  std::stable_sort (lcs.begin (), lcs.end (),
+                    [] (const SlSchedulerLcInfo& a, const SlSchedulerLcInfo& b)
+                    {
+                      return a.mcs > b.mcs;
+                    });
+}
+
+//-----------------------------------------------------------------------
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkEdfScheduler);
+
+TypeId
+MmWaveSidelinkEdfScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkEdfScheduler")
+    .SetParent<MmWaveSidelinkScheduler> ()
+    .AddConstructor<MmWaveSidelinkEdfScheduler> ()
+    .AddAttribute ("DelayBudget",
+                   "Delay budget of the logical channels in ms.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&MmWaveSidelinkEdfScheduler::m_delayBudget),
+                   MakeUintegerChecker<uint16_t> ())
+  ;
+  return tid;
+}
+
+MmWaveSidelinkEdfScheduler::MmWaveSidelinkEdfScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkEdfScheduler::~MmWaveSidelinkEdfScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MmWaveSidelinkEdfScheduler::SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs)
+{
+  // the deadline is negative if the budget has already been exceeded
+  uint16_t budget = m_delayBudget;
+  auto deadline = [budget] (const SlSchedulerLcInfo& lc) { return int32_t (budget) - int32_t (lc.holDelay); };
+
+  std::stable_sort (lcs.begin (), lcs.end (),
+                    [&deadline] (const SlSchedulerLcInfo& a, const SlSchedulerLcInfo& b)
+                    {
+                      if (deadline (a) != deadline (b))
+                      {
+                        return deadline (a) < deadline (b);
+                      }
+                      return a.mcs > b.mcs;
+                    });
+}
+
+} // namespace millicar
+
+} // namespace ns3
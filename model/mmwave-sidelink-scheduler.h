@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SCHEDULER_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SCHEDULER_H_
+
+#include <map>
+#include <vector>
+#include <ns3/object.h>
+#include <ns3/mmwave-phy-mac-common.h>
+#include "mmwave-sidelink-rb-mask.h"
+#include "mmwave-sidelink-tb-size-table.h"
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * State of an active logical channel, given as input to the scheduler
+ */
+struct SlSchedulerLcInfo
+{
+  uint8_t lcid; //!< the logical channel ID
+  uint16_t rnti; //!< the RNTI of the destination device
+  uint8_t mcs; //!< the MCS selected for the destination device
+  uint32_t requiredBytes; //!< the bytes waiting to be transmitted
+  uint16_t holDelay; //!< the head of line delay of the RLC queues in ms
+};
+
+/**
+ * Input of the scheduler
+ */
+struct SlSchedulerParams
+{
+  mmwave::SfnSf timingInfo; //!< the current slot
+  uint32_t availableSymbols; //!< the number of symbols which can be allocated
+  uint32_t subChannelSize; //!< number of RBs per sub-channel, if 0 the transport blocks use all the RBs
+  std::vector<SlSchedulerLcInfo> lcs; //!< the active logical channels, sorted by LCID
+};
+
+/**
+ * Resources assigned to a logical channel
+ */
+struct SlSchedulerGrant
+{
+  uint8_t lcid; //!< the logical channel ID
+  uint8_t symStart; //!< index of the first symbol
+  uint8_t numSym; //!< number of symbols
+  uint8_t mcs; //!< the MCS
+  uint32_t tbSize; //!< the TB size in bytes
+  Ptr<const MmWaveSidelinkRbMask> rbMask; //!< the RBs used by the transport block, if null all the RBs are used
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkScheduler
+ *
+ * Base class of the schedulers used by MmWaveSidelinkMac to share the slots
+ * assigned to a device among its active logical channels.
+ *
+ * The policies differ in the order in which the logical channels are
+ * served, defined by SortLogicalChannels. The resources are then assigned
+ * by ScheduleSymbols, which serves the logical channels one after the other
+ * using all the RBs, or by ScheduleSubChannels, which also splits the RBs in
+ * sub-channels.
+ */
+class MmWaveSidelinkScheduler : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkScheduler ();
+  virtual ~MmWaveSidelinkScheduler ();
+
+  /**
+   * Set the configuration parameters and the table used to compute the TB
+   * sizes
+   * \param pmc the PHY/MAC configuration parameters
+   * \param tbSizeTable the TB size table, built with the same configuration
+   *        parameters
+   */
+  void SetConfiguration (Ptr<mmwave::MmWavePhyMacCommon> pmc, Ptr<const MmWaveSidelinkTbSizeTable> tbSizeTable);
+
+  /**
+   * Allocate the resources of a slot to the active logical channels
+   * \param params the input of the scheduler
+   * \return the grants, sorted by first symbol
+   */
+  virtual std::vector<SlSchedulerGrant> Schedule (const SlSchedulerParams& params);
+
+protected:
+  // inherited from Object
+  virtual void DoDispose (void);
+
+  /**
+   * Sort the logical channels in the order in which they have to be served
+   * \param params the input of the scheduler
+   * \param lcs the logical channels to sort
+   */
+  virtual void SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) = 0;
+
+  /**
+   * Allocate the symbols to the logical channels, using all the RBs. Each
+   * logical channel receives the symbols it needs, in the order of lcs.
+   * \param params the input of the scheduler
+   * \param lcs the logical channels, sorted by SortLogicalChannels
+   * \return the grants
+   */
+  virtual std::vector<SlSchedulerGrant> ScheduleSymbols (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs);
+
+  /**
+   * Allocate the resources to the logical channels using both the symbols
+   * and the sub-channels. The resources are assigned in rounds: in each
+   * round, up to one logical channel per sub-channel is served, taking them
+   * in the order of lcs, and all the transport blocks start in the same
+   * symbol and last for the same number of symbols, so that a receiver can
+   * decode all those destined to it.
+   * \param params the input of the scheduler
+   * \param lcs the logical channels, sorted by SortLogicalChannels
+   * \return the grants
+   */
+  std::vector<SlSchedulerGrant> ScheduleSubChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs);
+
+  /**
+   * Compute the size of a transport block which uses only a subset of
+   * the RBs
+   * \param mcs the MCS
+   * \param numSym the number of symbols
+   * \param numRbs the number of RBs
+   * \return the TB size in bytes
+   */
+  uint32_t CalculateTbSize (uint8_t mcs, uint8_t numSym, uint32_t numRbs) const;
+
+  /**
+   * Compute the minimum number of symbols needed to transmit a transport
+   * block using only a subset of the RBs
+   * \param tbSize the TB size in bytes
+   * \param mcs the MCS
+   * \param numRbs the number of RBs
+   * \param maxSym the maximum number of symbols
+   * \return the number of symbols, at most maxSym
+   */
+  uint8_t GetMinNumSymForTbSize (uint32_t tbSize, uint8_t mcs, uint32_t numRbs, uint8_t maxSym) const;
+
+  Ptr<mmwave::MmWavePhyMacCommon> m_phyMacConfig; //!< the PHY/MAC configuration parameters
+  Ptr<const MmWaveSidelinkTbSizeTable> m_tbSizeTable; //!< the TB size table
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkRrScheduler
+ *
+ * Round robin scheduler. The symbols are split among the active logical
+ * channels with a max-min fair allocation: each logical channel receives the
+ * symbols it needs or an equal share of those left, and the symbols left by
+ * the integer division are assigned one at a time to the backlogged logical
+ * channels. Each slot starts from the logical channel following the last
+ * one served in the previous slot.
+ */
+class MmWaveSidelinkRrScheduler : public MmWaveSidelinkScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkRrScheduler ();
+  virtual ~MmWaveSidelinkRrScheduler ();
+
+  // inherited from MmWaveSidelinkScheduler
+  std::vector<SlSchedulerGrant> Schedule (const SlSchedulerParams& params) override;
+
+protected:
+  // inherited from MmWaveSidelinkScheduler
+  void SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) override;
+  std::vector<SlSchedulerGrant> ScheduleSymbols (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) override;
+
+private:
+  uint8_t m_lastLcid; //!< the last logical channel served
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkPfScheduler
+ *
+ * Proportional fair scheduler. The logical channels are served in
+ * decreasing order of the ratio between the rate achievable with the MCS of
+ * their destination and their average throughput, which is updated at each
+ * slot with an exponential moving average.
+ */
+class MmWaveSidelinkPfScheduler : public MmWaveSidelinkScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkPfScheduler ();
+  virtual ~MmWaveSidelinkPfScheduler ();
+
+  // inherited from MmWaveSidelinkScheduler
+  std::vector<SlSchedulerGrant> Schedule (const SlSchedulerParams& params) override;
+
+protected:
+  // inherited from MmWaveSidelinkScheduler
+  void SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) override;
+
+private:
+  double m_timeWindow; //!< the time window of the average throughput in slots
+  std::map<uint8_t, double> m_avgThroughput; //!< map containing the <LCID, average bytes per slot> pairs
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkMaxRateScheduler
+ *
+ * Max C/I scheduler. The logical channels are served in decreasing order of
+ * the MCS of their destination.
+ */
+class MmWaveSidelinkMaxRateScheduler : public MmWaveSidelinkScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkMaxRateScheduler ();
+  virtual ~MmWaveSidelinkMaxRateScheduler ();
+
+protected:
+  // inherited from MmWaveSidelinkScheduler
+  void SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) override;
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkEdfScheduler
+ *
+ * Earliest deadline first scheduler. The deadline of each logical channel
+ * is given by the DelayBudget minus the head of line delay of its RLC
+ * queues, and the logical channels are served in increasing order of
+ * deadline. The channels with the same deadline are served in decreasing
+ * order of MCS.
+ */
+class MmWaveSidelinkEdfScheduler : public MmWaveSidelinkScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkEdfScheduler ();
+  virtual ~MmWaveSidelinkEdfScheduler ();
+
+protected:
+  // inherited from MmWaveSidelinkScheduler
+  void SortLogicalChannels (const SlSchedulerParams& params, std::vector<SlSchedulerLcInfo>& lcs) override;
+
+private:
+  uint16_t m_delayBudget; //!< the delay budget of the logical channels in ms
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SCHEDULER_H_ */
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-sinr-summary.h"
+#include <ns3/assert.h>
+#include <cmath>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * Compute the statistics from the sum of the SINR values
+ * \param sum the sum of the SINR values
+ * \param n the number of values
+ * \return the SinrSummary
+ */
+static SinrSummary
+FinalizeSinrSummary (double sum, size_t n)
+{
+  SinrSummary summary;
+  if (n == 0)
+    {
+      return summary;
+    }
+  summary.mean = sum / n;
+  summary.meanDb = 10 * std::log10 (summary.mean);
+  return summary;
+}
+
+SinrSummary
+ComputeSinrSummary (const SpectrumValue& sinr)
+{
+  const size_t numBands = sinr.GetSpectrumModel ()->GetNumBands ();
+  double sum = 0.0;
+  for (auto it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); it++)
+    {
+      sum += *it;
+    }
+  return FinalizeSinrSummary (sum, numBands);
+}
+
+SinrSummary
+ComputeSinrSummary (const SpectrumValue& sinr, const std::vector<int>& map)
+{
+  double sum = 0.0;
+  for (int rb : map)
+    {
+      sum += sinr[rb];
+    }
+  return FinalizeSinrSummary (sum, map.size ());
+}
+
+double
+ComputeMiesm (const SpectrumValue& sinr, const std::vector<int>& map)
+{
+  NS_ASSERT_MSG (!map.empty (), "No band to be considered");
+  double sumLog = 0.0;
+  for (int rb : map)
+    {
+      sumLog += std::log2 (1.0 + sinr[rb]);
+    }
+  return std::pow (2.0, sumLog / map.size ()) - 1.0;
+}
+
+} // namespace millicar
+
+} // namespace ns3
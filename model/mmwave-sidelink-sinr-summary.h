@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SINR_SUMMARY_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SINR_SUMMARY_H_
+
+#include <ns3/spectrum-value.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * Statistics of the SINR perceived during a reception, computed once and
+ * shared among all the consumers of the SINR report.
+ */
+struct SinrSummary
+{
+  double mean {0.0}; //!< average SINR in linear units
+  double meanDb {0.0}; //!< average SINR in dB
+};
+
+/**
+ * Compute the statistics of the SINR with a single pass over the bands
+ * \param sinr the SINR perceived on each band
+ * \return the SinrSummary
+ */
+SinrSummary ComputeSinrSummary (const SpectrumValue& sinr);
+
+/**
+ * Compute the statistics of the SINR over a subset of the bands with a
+ * single pass
+ * \param sinr the SINR perceived on each band
+ * \param map the indexes of the bands to be considered
+ * \return the SinrSummary
+ */
+SinrSummary ComputeSinrSummary (const SpectrumValue& sinr, const std::vector<int>& map);
+
+/**
+ * Compute the capacity-based (MIESM) effective SINR over a subset of the
+ * bands, i.e., 2^(mean (log2 (1 + sinr))) - 1. It is computed only by the
+ * consumers which need it, since it requires a logarithm per band
+ * \param sinr the SINR perceived on each band
+ * \param map the indexes of the bands to be considered
+ * \return the effective SINR in linear units
+ */
+double ComputeMiesm (const SpectrumValue& sinr, const std::vector<int>& map);
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SINR_SUMMARY_H_ */
@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-slot-clock.h"
+#include "mmwave-sidelink-phy.h"
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkSlotClock");
+
+namespace millicar {
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkSlotClock);
+
+MmWaveSidelinkSlotClock::MmWaveSidelinkSlotClock ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_FATAL_ERROR ("This constructor should not be called");
+}
+
+MmWaveSidelinkSlotClock::MmWaveSidelinkSlotClock (Ptr<mmwave::MmWavePhyMacCommon> confParams)
+  : m_phyMacConfig (confParams)
+{
+  NS_LOG_FUNCTION (this);
+  m_tickEvent = Simulator::ScheduleNow (&MmWaveSidelinkSlotClock::Tick, this, mmwave::SfnSf (0, 0, 0));
+}
+
+MmWaveSidelinkSlotClock::~MmWaveSidelinkSlotClock ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+MmWaveSidelinkSlotClock::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkSlotClock")
+    .SetParent<Object> ()
+    .SetGroupName ("millicar")
+  ;
+  return tid;
+}
+
+void
+MmWaveSidelinkSlotClock::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_tickEvent.Cancel ();
+  m_phys.clear ();
+  m_phyMacConfig = nullptr;
+  Object::DoDispose ();
+}
+
+void
+MmWaveSidelinkSlotClock::AddPhy (Ptr<MmWaveSidelinkPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  NS_ASSERT_MSG (phy->GetConfigurationParameters () == m_phyMacConfig,
+                 "The PHYs driven by the same clock must share the configuration parameters");
+  phy->AttachToSlotClock ();
+  m_phys.push_back (phy);
+}
+
+uint32_t
+MmWaveSidelinkSlotClock::GetNPhys () const
+{
+  return m_phys.size ();
+}
+
+void
+MmWaveSidelinkSlotClock::Tick (mmwave::SfnSf timingInfo)
+{
+  NS_LOG_FUNCTION (this << timingInfo.m_frameNum << timingInfo.m_sfNum << timingInfo.m_slotNum);
+
+  for (auto& phy : m_phys)
+  {
+    phy->StartSlot (timingInfo);
+  }
+
+  // update the timing information
+  if (++timingInfo.m_slotNum == m_phyMacConfig->GetSlotsPerSubframe ())
+  {
+    timingInfo.m_slotNum = 0;
+    if (++timingInfo.m_sfNum == m_phyMacConfig->GetSubframesPerFrame ())
+    {
+      timingInfo.m_sfNum = 0;
+      timingInfo.m_frameNum++;
+    }
+  }
+  m_tickEvent = Simulator::Schedule (m_phyMacConfig->GetSlotPeriod (), &MmWaveSidelinkSlotClock::Tick, this, timingInfo);
+}
+
+} // namespace millicar
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SLOT_CLOCK_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SLOT_CLOCK_H_
+
+#include <vector>
+#include <ns3/object.h>
+#include <ns3/event-id.h>
+#include <ns3/mmwave-phy-mac-common.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+class MmWaveSidelinkPhy;
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkSlotClock
+ *
+ * Slot clock shared by multiple MmWaveSidelinkPhy instances. Instead of
+ * having each PHY schedule its own StartSlot event, the clock schedules a
+ * single event per slot and starts the slot of all the registered PHYs, in
+ * the order in which they were added. Since the PHYs would otherwise start
+ * their slots at the same time and in the same order, the behavior of each
+ * device is not affected.
+ *
+ * All the registered PHYs must share the same configuration parameters.
+ * A PHY driven by the clock starts every slot, hence the FastForwardIdleSlots
+ * option of MmWaveSidelinkPhy has no effect.
+ */
+class MmWaveSidelinkSlotClock : public Object
+{
+public:
+  /**
+   * Dummy constructor, it is not used
+   */
+  MmWaveSidelinkSlotClock ();
+
+  /**
+   * MmWaveSidelinkSlotClock real constructor. The first slot is started
+   * immediately.
+   * \param confParams instance of mmwave::MmWavePhyMacCommon containing the
+   *        configuration parameters
+   */
+  MmWaveSidelinkSlotClock (Ptr<mmwave::MmWavePhyMacCommon> confParams);
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveSidelinkSlotClock ();
+
+  // inherited from Object
+  static TypeId GetTypeId (void);
+
+  /**
+   * Register a PHY. The PHY stops scheduling its own slots and is driven by
+   * this clock from the next slot on.
+   * \param phy the PHY
+   */
+  void AddPhy (Ptr<MmWaveSidelinkPhy> phy);
+
+  /**
+   * Returns the number of registered PHYs
+   * \return the number of PHYs
+   */
+  uint32_t GetNPhys () const;
+
+protected:
+  // inherited from Object
+  virtual void DoDispose (void) override;
+
+private:
+  /**
+   * Start a slot for all the registered PHYs and schedule the next one
+   * \param timingInfo the structure containing the timing information
+   */
+  void Tick (mmwave::SfnSf timingInfo);
+
+  Ptr<mmwave::MmWavePhyMacCommon> m_phyMacConfig; //!< the configuration parameters
+  std::vector<Ptr<MmWaveSidelinkPhy> > m_phys; //!< the registered PHYs
+  EventId m_tickEvent; //!< the event of the next slot
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SLOT_CLOCK_H_ */
@@ -24,7 +24,10 @@
 #include <ns3/log.h>
 #include <ns3/ptr.h>
 #include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/trace-source-accessor.h>
 #include <cmath>
+#include <algorithm>
 #include <ns3/simulator.h>
 #include <ns3/antenna-model.h>
 #include "mmwave-sidelink-spectrum-phy.h"
@@ -76,8 +79,19 @@ static const double EffectiveCodingRate[29] = {
 };
 
 MmWaveSidelinkSpectrumPhy::MmWaveSidelinkSpectrumPhy ()
-  : m_state (IDLE),
-    m_componentCarrierId (0)
+  : m_rnti (0),
+    m_state (IDLE),
+    m_componentCarrierId (0),
+    m_errorModelUsed (false),
+    m_errorModelAllocationsSaved (0),
+    m_culledSignals (0),
+    m_rxHalfDuplexDrops (0),
+    m_rxCollisionDrops (0),
+    m_rxNotForMeDrops (0),
+    m_rxDecodeFailures (0),
+    m_rxSuccesses (0),
+    m_beamCacheHits (0),
+    m_beamCacheMisses (0)
 {
   m_interferenceData = CreateObject<mmWaveInterference> ();
   m_random = CreateObject<UniformRandomVariable> ();
@@ -107,6 +121,115 @@ MmWaveSidelinkSpectrumPhy::GetTypeId (void)
                    TypeIdValue (MmWaveLteMiErrorModel::GetTypeId ()),
                    MakeTypeIdAccessor (&MmWaveSidelinkSpectrumPhy::SetErrorModelType),
                    MakeTypeIdChecker ())
+    .AddAttribute ("ErrorModelAllocationsSaved",
+                   "Number of error model instantiations avoided by reusing the error model instance",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_errorModelAllocationsSaved),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RxPowerFloor",
+                   "Signals not received by this device and whose power is below the noise power "
+                   "by more than this value (in dB) in every band are not accounted as interference. "
+                   "Since many culled signals may add up to a significant interference, the floor "
+                   "should be well below 0 dB. The default value -1e9 dB, or any lower value, "
+                   "means that no signal is culled",
+                   DoubleValue (-1e9),
+                   MakeDoubleAccessor (&MmWaveSidelinkSpectrumPhy::SetRxPowerFloor,
+                                       &MmWaveSidelinkSpectrumPhy::GetRxPowerFloor),
+                   MakeDoubleChecker<double> ())
+    .AddTraceSource ("CulledSignals",
+                     "Number of signals discarded because of the received power floor",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_culledSignals),
+                     "ns3::TracedValueCallback::Uint64")
+    .AddTraceSource ("RxHalfDuplex",
+                     "A TB for this device has been lost since the device was transmitting",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_rxHalfDuplexTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::RxOutcomeTracedCallback")
+    .AddTraceSource ("RxCollision",
+                     "A TB for this device has been lost since the device was receiving another TB",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_rxCollisionTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::RxOutcomeTracedCallback")
+    .AddTraceSource ("RxNotForMe",
+                     "A TB destined to another device has been discarded",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_rxNotForMeTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::RxOutcomeTracedCallback")
+    .AddTraceSource ("RxDecodeFailure",
+                     "A TB for this device has been corrupted",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_rxDecodeFailureTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::RxOutcomeTracedCallback")
+    .AddTraceSource ("RxSuccess",
+                     "A TB for this device has been correctly received",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_rxSuccessTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::RxOutcomeTracedCallback")
+    .AddTraceSource ("SlSinrReport",
+                     "SINR report of each received TB",
+                     MakeTraceSourceAccessor (&MmWaveSidelinkSpectrumPhy::m_slSinrReportTrace),
+                     "ns3::millicar::MmWaveSidelinkSpectrumPhy::SlSinrReportTracedCallback")
+    .AddAttribute ("RxHalfDuplexDrops",
+                   "Number of TBs for this device lost since the device was transmitting",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_rxHalfDuplexDrops),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RxCollisionDrops",
+                   "Number of TBs for this device lost since the device was receiving another TB",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_rxCollisionDrops),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RxNotForMeDrops",
+                   "Number of TBs destined to other devices",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_rxNotForMeDrops),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RxDecodeFailures",
+                   "Number of corrupted TBs for this device",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_rxDecodeFailures),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("RxSuccesses",
+                   "Number of TBs for this device correctly received",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_rxSuccesses),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("BeamCacheValidity",
+                   "Maximum time for which a beamforming vector is reused for the same device. "
+                   "If 0, the vectors are computed at each transmission and reception. If "
+                   "negative, MmWaveVehicularHelper sets it to the UpdatePeriod of the channel "
+                   "model, or disables the cache if the UpdatePeriod is 0. The channel is also "
+                   "regenerated when the LOS condition changes, hence a cached vector may be "
+                   "stale for up to this time",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MmWaveSidelinkSpectrumPhy::m_beamCacheValidity),
+                   MakeTimeChecker ())
+    .AddAttribute ("BeamCacheMaxDistance",
+                   "Maximum displacement (in m) of the other device with respect to this device "
+                   "for a cached beamforming vector to be reused",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkSpectrumPhy::m_beamCacheMaxDistance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("BeamCacheMaxAngle",
+                   "Maximum change of the direction (in degrees) of the other device with respect "
+                   "to this device, and of the bearing and downtilt angles of the antenna arrays "
+                   "of the two devices, for a cached beamforming vector to be reused",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&MmWaveSidelinkSpectrumPhy::m_beamCacheMaxAngle),
+                   MakeDoubleChecker<double> (0.0, 180.0))
+    .AddAttribute ("BeamCacheHits",
+                   "Number of beamforming vectors retrieved from the beam cache",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_beamCacheHits),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("BeamCacheMisses",
+                   "Number of beamforming vectors computed by the beamforming model",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveSidelinkSpectrumPhy::m_beamCacheMisses),
+                   MakeUintegerChecker<uint64_t> ())
   ;
 
   return tid;
@@ -114,7 +237,9 @@ MmWaveSidelinkSpectrumPhy::GetTypeId (void)
 void
 MmWaveSidelinkSpectrumPhy::DoDispose ()
 {
-
+  m_errorModel = nullptr;
+  m_beamCache.clear ();
+  m_harqRxStates.clear ();
 }
 
 void
@@ -127,6 +252,9 @@ MmWaveSidelinkSpectrumPhy::Reset ()
   //m_endRxCtrlEvent.Cancel ();
   //m_rxControlMessageList.clear ();
   m_rxTransportBlock.clear ();
+  m_harqRxStates.clear ();
+  m_rxRbBits.reset ();
+  m_txRbBits.reset ();
 }
 
 void
@@ -141,6 +269,11 @@ MmWaveSidelinkSpectrumPhy::SetDevice (Ptr<NetDevice> d)
   NS_ABORT_MSG_IF(!DynamicCast<MmWaveVehicularNetDevice>(d),
     "The MmWaveSidelinkSpectrumPhy only works with MmWaveVehicularNetDevices");
   m_device = d;
+
+  // the RNTI is assigned to the MAC before the device is set, hence
+  // it can be cached here instead of being looked up for each signal
+  m_rnti = DynamicCast<MmWaveVehicularNetDevice>(d)->GetMac ()->GetRnti ();
+  NS_ASSERT_MSG (m_rnti != 0, "The RNTI of the MAC must be set before the device");
 }
 
 Ptr<NetDevice>
@@ -199,6 +332,7 @@ MmWaveSidelinkSpectrumPhy::SetNoisePowerSpectralDensity (Ptr<const SpectrumValue
   NS_ASSERT (noisePsd);
   m_rxSpectrumModel = noisePsd->GetSpectrumModel ();
   m_interferenceData->SetNoisePowerSpectralDensity (noisePsd);
+  m_noisePsd = noisePsd;
 }
 
 void
@@ -223,7 +357,14 @@ void
 MmWaveSidelinkSpectrumPhy::SetSidelinkSinrReportCallback (MmWaveSidelinkSinrReportCallback c)
 {
   NS_LOG_FUNCTION (this);
-  m_slSinrReportCallback.push_back(c);
+  m_slSinrReportCallback = c;
+}
+
+void
+MmWaveSidelinkSpectrumPhy::SetSidelinkSensingCallback (MmWaveSidelinkSensingCallback c)
+{
+  NS_LOG_FUNCTION (this);
+  m_slSensingCallback = c;
 }
 
 void
@@ -237,6 +378,14 @@ MmWaveSidelinkSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> params)
 
   if (mmwaveSidelinkParams)
     {
+      // report the received power of the signal, which is used to sense the
+      // occupancy of the slots. The device cannot sense while transmitting
+      if (m_state != TX && !m_slSensingCallback.IsNull ())
+        {
+          double rssiDbm = 10 * std::log10 (Integral (*params->psd)) + 30;
+          m_slSensingCallback (mmwaveSidelinkParams->senderRnti, mmwaveSidelinkParams->destinationRnti, rssiDbm);
+        }
+
       // TODO remove dead code after testing that the following code can be
       // handled by the MmWaveSidelinkSpectrumPhy state machine
       //bool isAllocated = true;
@@ -256,7 +405,7 @@ MmWaveSidelinkSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> params)
     else
     {
       // other type of signal that needs to be counted as interference
-      m_interferenceData->AddSignal (params->psd, params->duration);
+      AddInterferingSignal (params);
     }
 }
 
@@ -271,6 +420,16 @@ MmWaveSidelinkSpectrumPhy::StartRxData (Ptr<MmWaveSidelinkSpectrumSignalParamete
       // If there are other intereferent devices that transmit in the same slot, the current
       // device simply does not consider the signal and goes on with the transmission. The code does not raise any errors since
       // otherwise we are not able to study scenarios where interference could be an issue.
+      if (m_rnti == params->destinationRnti)
+        {
+          m_rxHalfDuplexDrops++;
+          m_rxHalfDuplexTrace (params->senderRnti, params->destinationRnti, params->size);
+        }
+      else
+        {
+          m_rxNotForMeDrops++;
+          m_rxNotForMeTrace (params->senderRnti, params->destinationRnti, params->size);
+        }
       break;
     case RX_CTRL:
       NS_FATAL_ERROR ("Cannot receive control in data period");
@@ -278,54 +437,58 @@ MmWaveSidelinkSpectrumPhy::StartRxData (Ptr<MmWaveSidelinkSpectrumSignalParamete
     case RX_DATA:
       // If this device is in the RX_DATA state and another call to StartRx is
       // triggered, it means that multiple concurrent signals are being received.
-      // In this case, we assume that the device will synchronize with the first
-      // received signal, while the other will act as interferers
-      m_interferenceData->AddSignal (params->psd, params->duration);
+      // If the new signal is destined to this device, starts and ends together
+      // with the ones being received and uses a disjoint set of RBs, it is
+      // received as well (frequency-division reception). Otherwise, it acts
+      // as an interferer
+      if (m_rnti == params->destinationRnti
+          && m_firstRxStart == Simulator::Now ()
+          && m_firstRxDuration == params->duration
+          && !(m_rxRbBits & params->rbBitmap->GetBits ()).any ())
+        {
+          NS_LOG_LOGIC (this << " receive a concurrent TB from rnti " << params->senderRnti);
+          StartRxTransportBlock (params);
+        }
+      else
+        {
+          if (m_rnti == params->destinationRnti)
+            {
+              m_rxCollisionDrops++;
+              m_rxCollisionTrace (params->senderRnti, params->destinationRnti, params->size);
+            }
+          else
+            {
+              m_rxNotForMeDrops++;
+              m_rxNotForMeTrace (params->senderRnti, params->destinationRnti, params->size);
+            }
+          AddInterferingSignal (params);
+        }
       break;
     case IDLE:
       {
         // check if the packet is for this device, otherwise
         // consider it only for the interference
-        m_interferenceData->AddSignal (params->psd, params->duration);
-        uint16_t thisDeviceRnti =
-          DynamicCast<MmWaveVehicularNetDevice>(m_device)->GetMac()->GetRnti();
-        if(thisDeviceRnti == params->destinationRnti)
+        if(m_rnti == params->destinationRnti)
         {
-          // this is a useful signal
-          m_interferenceData->StartRx (params->psd);
+          // first transmission, i.e., we're IDLE and we start RX
+          NS_ASSERT (m_rxTransportBlock.empty ());
+          m_firstRxStart = Simulator::Now ();
+          m_firstRxDuration = params->duration;
+          NS_LOG_LOGIC (this << " scheduling EndRx with delay " << params->duration.GetSeconds () << "s");
 
-          if (m_rxTransportBlock.empty ())
-            {
-              NS_ASSERT (m_state == IDLE);
-              // first transmission, i.e., we're IDLE and we start RX
-              m_firstRxStart = Simulator::Now ();
-              m_firstRxDuration = params->duration;
-              NS_LOG_LOGIC (this << " scheduling EndRx with delay " << params->duration.GetSeconds () << "s");
-
-              m_endRxDataEvent = Simulator::Schedule (params->duration, &MmWaveSidelinkSpectrumPhy::EndRxData, this);
-            }
-          else
-            {
-              NS_ASSERT (m_state == RX_DATA);
-              // sanity check: if there are multiple RX events, they
-              // should occur at the same time and have the same
-              // duration, otherwise the interference calculation
-              // won't be correct
-              NS_ASSERT ((m_firstRxStart == Simulator::Now ()) && (m_firstRxDuration == params->duration));
-            }
+          m_endRxDataEvent = Simulator::Schedule (params->duration, &MmWaveSidelinkSpectrumPhy::EndRxData, this);
 
           ChangeState (RX_DATA);
-          if (params->packetBurst && !params->packetBurst->GetPackets ().empty ())
-            {
-              TbInfo_t tbInfo = {params->packetBurst, params->size, params->mcs, params->numSym, params->senderRnti, params->rbBitmap};
-              m_rxTransportBlock.push_back (tbInfo);
-            }
+          StartRxTransportBlock (params);
         }
         else
         {
           NS_LOG_LOGIC (this << " not in sync with this signal (rnti="
               << params->destinationRnti  << ", rnti of the device="
-              << thisDeviceRnti << ")");
+              << m_rnti << ")");
+          m_rxNotForMeDrops++;
+          m_rxNotForMeTrace (params->senderRnti, params->destinationRnti, params->size);
+          AddInterferingSignal (params);
         }
         //m_rxControlMessageList.insert (m_rxControlMessageList.end (), params->ctrlMsgList.begin (), params->ctrlMsgList.end ());
       }
@@ -335,6 +498,49 @@ MmWaveSidelinkSpectrumPhy::StartRxData (Ptr<MmWaveSidelinkSpectrumSignalParamete
     }
 }
 
+void
+MmWaveSidelinkSpectrumPhy::StartRxTransportBlock (Ptr<MmWaveSidelinkSpectrumSignalParameters> params)
+{
+  // this is a useful signal, the interference model sums the signals which
+  // are received at the same time on disjoint RBs
+  m_interferenceData->AddSignal (params->psd, params->duration);
+  m_interferenceData->StartRx (params->psd);
+  m_rxRbBits |= params->rbBitmap->GetBits ();
+
+  if (params->packetBurst && !params->packetBurst->GetPackets ().empty ())
+    {
+      TbInfo_t tbInfo = {params->packetBurst, params->size, params->mcs, params->numSym, params->senderRnti, params->rbBitmap,
+                         params->harqId, params->ndi, params->rv};
+      m_rxTransportBlock.push_back (tbInfo);
+    }
+}
+
+void
+MmWaveSidelinkSpectrumPhy::AddInterferingSignal (Ptr<const SpectrumSignalParameters> params)
+{
+  // the signal does not carry data for this device, hence if it is too weak
+  // in every band it can be ignored without affecting the SINR of the
+  // useful signals. The comparison is done per band, since a signal
+  // confined to a few RBs may be strong on those RBs even if its total
+  // power is low
+  if (m_rxPowerFloor > 0 && m_noisePsd)
+    {
+      bool belowFloor = true;
+      auto noiseIt = m_noisePsd->ConstValuesBegin ();
+      for (auto it = params->psd->ConstValuesBegin (); belowFloor && it != params->psd->ConstValuesEnd (); it++, noiseIt++)
+        {
+          belowFloor = *it < m_rxPowerFloor * (*noiseIt);
+        }
+      if (belowFloor)
+        {
+          NS_LOG_LOGIC (this << " discard signal below the received power floor");
+          m_culledSignals++;
+          return;
+        }
+    }
+  m_interferenceData->AddSignal (params->psd, params->duration);
+}
+
 // void
 // MmWaveSidelinkSpectrumPhy::StartRxCtrl (Ptr<SpectrumSignalParameters> params)
 // {
@@ -378,7 +584,6 @@ MmWaveSidelinkSpectrumPhy::EndRxData ()
   NS_LOG_FUNCTION (this);
   m_interferenceData->EndRx ();
 
-  double sinrAvg = Sum (m_sinrPerceived) / (m_sinrPerceived.GetSpectrumModel ()->GetNumBands ());
 
   NS_ASSERT (m_state = RX_DATA);
 
@@ -387,31 +592,60 @@ MmWaveSidelinkSpectrumPhy::EndRxData ()
     for (std::list<TbInfo_t>::const_iterator i = m_rxTransportBlock.begin ();
          i != m_rxTransportBlock.end (); ++i)
      {
-       // Here we need to initialize an empty harqInfoList since it is mandatory input
-       // for the method. Since the vector is empty, no harq procedures are triggered (as we want)
-       const MmWaveErrorModel::MmWaveErrorModelHistory& harqInfoList {};
-
-       // create the error model
-       ObjectFactory emFactory;
-       emFactory.SetTypeId (m_errorModelType);
-       Ptr<MmWaveErrorModel> errorModel = DynamicCast<MmWaveErrorModel> (emFactory.Create ());
-       
-       NS_LOG_DEBUG ("average sinr " << 10*log10 (sinrAvg) << " MCS " <<  (uint16_t)(*i).mcs);
-       Ptr<MmWaveErrorModelOutput> tbStats = errorModel->GetTbDecodificationStats (m_sinrPerceived, 
-                                                                                     (*i).rbBitmap, 
-                                                                                     (*i).size, 
-                                                                                     (*i).mcs, 
-                                                                                     harqInfoList);
-
-       // trigger callbacks
-       for (auto& it : m_slSinrReportCallback)
-        {
-          it(m_sinrPerceived, (*i).rnti, (*i).numSym, (*i).size, (*i).mcs); // TODO also export corrupt and tbler)
-        }
+       // retrieve the outputs of the error model for the previous
+       // transmissions of this TB, which are combined with the current one.
+       // The history is reset when a new TB is sent with the HARQ process
+       HarqRxState& harqState = m_harqRxStates [std::make_pair ((*i).rnti, (*i).harqId)];
+       if ((*i).rv == 0 || harqState.ndi != (*i).ndi)
+       {
+         harqState.ndi = (*i).ndi;
+         harqState.history.clear ();
+       }
+
+       // the error model instance is created by SetErrorModelType and reused
+       // for all the received TBs, hence an instantiation is saved for each
+       // TB after the first one
+       NS_ASSERT_MSG (m_errorModel, "The error model has not been created");
+       if (m_errorModelUsed)
+       {
+         m_errorModelAllocationsSaved++;
+       }
+       m_errorModelUsed = true;
+
+       // compute the statistics of the SINR over the RBs of this TB once,
+       // they are shared by all the consumers of the report
+       SinrSummary sinrSummary = ComputeSinrSummary (m_sinrPerceived, (*i).rbBitmap->GetIndexes ());
+
+       NS_LOG_DEBUG ("average sinr " << sinrSummary.meanDb << " MCS " <<  (uint16_t)(*i).mcs);
+       Ptr<MmWaveErrorModelOutput> tbStats = m_errorModel->GetTbDecodificationStats (m_sinrPerceived,
+                                                                                    (*i).rbBitmap->GetIndexes (),
+                                                                                    (*i).size,
+                                                                                    (*i).mcs,
+                                                                                    harqState.history);
 
        bool corrupt = m_random->GetValue () > tbStats->m_tbler ? false : true;
+
+       // keep the output for the combining with the retransmissions
+       if (corrupt)
+       {
+         harqState.history.push_back (tbStats);
+       }
+       else
+       {
+         harqState.history.clear ();
+       }
+
+       // report the SINR to the PHY and to the trace sinks
+       SlSinrReportInfo report {(*i).rnti, (*i).numSym, (*i).size, (*i).mcs, sinrSummary, tbStats->m_tbler, corrupt, (*i).harqId};
+       if (!m_slSinrReportCallback.IsNull ())
+        {
+          m_slSinrReportCallback (m_sinrPerceived, report);
+        }
+       m_slSinrReportTrace (report);
        if(!corrupt)
        {
+         m_rxSuccesses++;
+         m_rxSuccessTrace ((*i).rnti, m_rnti, (*i).size);
          Ptr<PacketBurst> burst = (*i).packetBurst;
          for (std::list<Ptr<Packet> >::const_iterator j = (*burst).Begin (); j != (*burst).End (); ++j)
          {
@@ -428,6 +662,8 @@ MmWaveSidelinkSpectrumPhy::EndRxData ()
        else
        {
          NS_LOG_INFO ("TB failed");
+         m_rxDecodeFailures++;
+         m_rxDecodeFailureTrace ((*i).rnti, m_rnti, (*i).size);
        }
      }
   }
@@ -441,6 +677,7 @@ MmWaveSidelinkSpectrumPhy::EndRxData ()
 
   m_state = IDLE;
   m_rxTransportBlock.clear ();
+  m_rxRbBits.reset ();
   //m_rxControlMessageList.clear ();
 }
 
@@ -471,7 +708,10 @@ MmWaveSidelinkSpectrumPhy::StartTxDataFrames (Ptr<PacketBurst> pb,
   uint8_t numSym,
   uint16_t senderRnti,
   uint16_t destinationRnti,
-  std::vector<int> rbBitmap)
+  Ptr<const MmWaveSidelinkRbMask> rbBitmap,
+  uint8_t harqId,
+  uint8_t ndi,
+  uint8_t rv)
 {
   NS_LOG_FUNCTION (this);
 
@@ -484,13 +724,18 @@ MmWaveSidelinkSpectrumPhy::StartTxDataFrames (Ptr<PacketBurst> pb,
       NS_FATAL_ERROR ("Cannot transmit while receiving");
       break;
     case TX:
-      NS_FATAL_ERROR ("Cannot transmit while a different transmission is still on");
-      break;
+      // another TB can be transmitted at the same time on different RBs
+      if ((m_txRbBits & rbBitmap->GetBits ()).any ())
+        {
+          NS_FATAL_ERROR ("Cannot transmit while a different transmission is still on");
+        }
+      // fall through
     case IDLE:
       {
         NS_ASSERT (m_txPsd);
 
         m_state = TX;
+        m_txRbBits |= rbBitmap->GetBits ();
         Ptr<MmWaveSidelinkSpectrumSignalParameters> txParams = Create<MmWaveSidelinkSpectrumSignalParameters> ();
         txParams->duration = duration;
         txParams->txPhy = this->GetObject<SpectrumPhy> ();
@@ -504,11 +749,19 @@ MmWaveSidelinkSpectrumPhy::StartTxDataFrames (Ptr<PacketBurst> pb,
         txParams->senderRnti = senderRnti;
         txParams->size = size;
         txParams->rbBitmap = rbBitmap;
+        txParams->harqId = harqId;
+        txParams->ndi = ndi;
+        txParams->rv = rv;
 
         m_channel->StartTx (txParams);
 
         // The end of the tranmission is reduced by 1 ns to avoid collision in case of a consecutive tranmission in the same slot.
-        m_endTxEvent = Simulator::Schedule (duration - NanoSeconds(1.0), &MmWaveSidelinkSpectrumPhy::EndTx, this);
+        // If other TBs are being transmitted, the state changes when the last one ends.
+        if (!m_endTxEvent.IsRunning () || Simulator::GetDelayLeft (m_endTxEvent) < duration - NanoSeconds (1.0))
+          {
+            m_endTxEvent.Cancel ();
+            m_endTxEvent = Simulator::Schedule (duration - NanoSeconds(1.0), &MmWaveSidelinkSpectrumPhy::EndTx, this);
+          }
       }
       break;
     default:
@@ -559,6 +812,7 @@ MmWaveSidelinkSpectrumPhy::EndTx ()
   NS_ASSERT (m_state == TX);
 
   m_state = IDLE;
+  m_txRbBits.reset ();
 }
 
 Ptr<SpectrumChannel>
@@ -593,7 +847,7 @@ MmWaveSidelinkSpectrumPhy::UpdateSinrPerceived (const SpectrumValue& sinr)
   m_sinrPerceived = sinr;
 
   // TODO create trace callback to fire everytime the SINR is updated
-  NS_LOG_DEBUG(this << " " << Sum(m_sinrPerceived)/m_sinrPerceived.GetSpectrumModel()->GetNumBands());
+  // the statistics of the SINR are computed once in EndRxData
 }
 
 void
@@ -609,7 +863,99 @@ MmWaveSidelinkSpectrumPhy::ConfigureBeamforming (Ptr<NetDevice> dev)
     {
       antenna = vehicularDevice->GetAntennaArray ();
     }
+
+  // without the mobility models the validity of a cached vector can not be
+  // checked, hence the cache is not used
+  Ptr<MobilityModel> otherMobility = dev->GetNode () ? dev->GetNode ()->GetObject<MobilityModel> () : nullptr;
+  if (!m_beamCacheValidity.IsStrictlyPositive () || !m_mobility || !otherMobility)
+    {
+      m_beamforming->SetBeamformingVectorForDevice (dev, antenna);
+      return;
+    }
+
+  BeamCacheEntry current;
+  current.m_relativePosition = otherMobility->GetPosition () - m_mobility->GetPosition ();
+  GetArrayOrientation (m_antenna, current.m_bearing, current.m_downtilt);
+  GetArrayOrientation (antenna, current.m_otherBearing, current.m_otherDowntilt);
+
+  auto it = m_beamCache.find (dev);
+  if (it != m_beamCache.end () && IsBeamValid (it->second, current))
+    {
+      NS_LOG_LOGIC ("Reuse the beamforming vector for device " << dev);
+      m_antenna->SetBeamformingVector (it->second.m_bfVector);
+      m_beamCacheHits++;
+      return;
+    }
+
   m_beamforming->SetBeamformingVectorForDevice (dev, antenna);
+  m_beamCacheMisses++;
+
+  current.m_bfVector = m_antenna->GetBeamformingVector ();
+  current.m_expiration = Simulator::Now () + m_beamCacheValidity;
+  m_beamCache[dev] = current;
+}
+
+bool
+MmWaveSidelinkSpectrumPhy::IsBeamValid (const BeamCacheEntry& entry, const BeamCacheEntry& current) const
+{
+  if (Simulator::Now () >= entry.m_expiration)
+    {
+      return false;
+    }
+
+  // the beam is steered in the coordinate system of the arrays, hence it
+  // is stale if either device rotated its array
+  if (GetAngleDifference (entry.m_bearing, current.m_bearing) > m_beamCacheMaxAngle
+      || GetAngleDifference (entry.m_downtilt, current.m_downtilt) > m_beamCacheMaxAngle
+      || GetAngleDifference (entry.m_otherBearing, current.m_otherBearing) > m_beamCacheMaxAngle
+      || GetAngleDifference (entry.m_otherDowntilt, current.m_otherDowntilt) > m_beamCacheMaxAngle)
+    {
+      return false;
+    }
+
+  const Vector& relativePosition = current.m_relativePosition;
+  if (CalculateDistance (entry.m_relativePosition, relativePosition) > m_beamCacheMaxDistance)
+    {
+      return false;
+    }
+
+  // compute the angle between the old and the new direction of the other
+  // device
+  double oldNorm = entry.m_relativePosition.GetLength ();
+  double newNorm = relativePosition.GetLength ();
+  if (oldNorm == 0.0 || newNorm == 0.0)
+    {
+      return false;
+    }
+  double cosAngle = (entry.m_relativePosition.x * relativePosition.x
+                     + entry.m_relativePosition.y * relativePosition.y
+                     + entry.m_relativePosition.z * relativePosition.z) / (oldNorm * newNorm);
+  double angle = std::acos (std::min (1.0, std::max (-1.0, cosAngle))) * 180.0 / M_PI;
+  return angle <= m_beamCacheMaxAngle;
+}
+
+void
+MmWaveSidelinkSpectrumPhy::GetArrayOrientation (Ptr<const PhasedArrayModel> array, double& bearing, double& downtilt)
+{
+  // the orientation is defined only for the arrays which expose it, e.g.,
+  // UniformPlanarArray, the others are considered fixed
+  DoubleValue value;
+  bearing = array && array->GetAttributeFailSafe ("BearingAngle", value) ? value.Get () : 0.0;
+  downtilt = array && array->GetAttributeFailSafe ("DowntiltAngle", value) ? value.Get () : 0.0;
+}
+
+double
+MmWaveSidelinkSpectrumPhy::GetAngleDifference (double a, double b)
+{
+  double diff = std::fmod (std::abs (a - b), 2 * M_PI);
+  return std::min (diff, 2 * M_PI - diff) * 180.0 / M_PI;
+}
+
+void
+MmWaveSidelinkSpectrumPhy::ClearBeamCache ()
+{
+  NS_LOG_FUNCTION (this);
+  m_beamCache.clear ();
 }
 
 void
@@ -624,5 +970,39 @@ MmWaveSidelinkSpectrumPhy::SetErrorModelType (TypeId errorModelType)
 {
   NS_ABORT_MSG_IF (!errorModelType.IsChildOf (MmWaveErrorModel::GetTypeId ()),
                    "The error model must be a subclass of MmWaveErrorModel!");
+
+  // rebuild the error model instance only if the type changed
+  if (m_errorModel && m_errorModelType == errorModelType)
+    {
+      return;
+    }
+
   m_errorModelType = errorModelType;
+  ObjectFactory emFactory;
+  emFactory.SetTypeId (m_errorModelType);
+  m_errorModel = DynamicCast<MmWaveErrorModel> (emFactory.Create ());
+  m_errorModelUsed = false;
+  NS_LOG_DEBUG ("Created error model of type " << m_errorModelType.GetName ());
+}
+
+void
+MmWaveSidelinkSpectrumPhy::SetRxPowerFloor (double floorDb)
+{
+  NS_LOG_FUNCTION (this << floorDb);
+  m_rxPowerFloorDb = floorDb;
+
+  // the linear floor of the default -1e9 dB is 0, which disables the culling
+  m_rxPowerFloor = floorDb > -1e9 ? std::pow (10.0, floorDb / 10.0) : 0.0;
+}
+
+double
+MmWaveSidelinkSpectrumPhy::GetRxPowerFloor () const
+{
+  return m_rxPowerFloorDb;
+}
+
+uint64_t
+MmWaveSidelinkSpectrumPhy::GetErrorModelAllocationsSaved () const
+{
+  return m_errorModelAllocationsSaved;
 }
@@ -23,6 +23,7 @@
 #ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SPECTRUM_PHY_H_
 #define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_SPECTRUM_PHY_H_
 
+#include <map>
 #include <ns3/object-factory.h>
 #include <ns3/event-id.h>
 #include <ns3/spectrum-value.h>
@@ -36,7 +37,11 @@
 #include <ns3/data-rate.h>
 #include <ns3/generic-phy.h>
 #include <ns3/packet-burst.h>
+#include <ns3/traced-value.h>
+#include <ns3/traced-callback.h>
 #include "mmwave-sidelink-spectrum-signal-parameters.h"
+#include "mmwave-sidelink-sinr-summary.h"
+#include "mmwave-sidelink-sap.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/mmwave-interference.h"
 #include "ns3/mmwave-control-messages.h"
@@ -54,7 +59,10 @@ struct TbInfo_t
   uint8_t mcs; ///< MCS
   uint8_t numSym; ///< number of symbols used to transmit this TB
   uint16_t rnti; ///< RNTI of the device which is sending the packet
-  std::vector<int> rbBitmap; ///< Resource block bitmap
+  Ptr<const MmWaveSidelinkRbMask> rbBitmap; ///< Resource block bitmap
+  uint8_t harqId; ///< HARQ process ID
+  uint8_t ndi; ///< new data indicator
+  uint8_t rv; ///< redundancy version
 };
 
 /**
@@ -70,11 +78,19 @@ typedef Callback< void, Ptr<Packet> > MmWavePhyRxDataEndOkCallback;
 * the SINR of the channel
 *
 * @param sinr estimated SINR value
-* @param rnti RNTI of the transmitting device
-* @param numSym number of symbols associated to the transport block
-* @param size size of the transport block
+* @param report information about the received transport block
 */
-typedef Callback< void, const SpectrumValue&, uint16_t, uint8_t, uint32_t, uint8_t> MmWaveSidelinkSinrReportCallback;
+typedef Callback< void, const SpectrumValue&, const SlSinrReportInfo&> MmWaveSidelinkSinrReportCallback;
+
+/**
+* This method is used by the MmWaveSidelinkSpectrumPhy to notify the PHY about
+* each sensed sidelink signal
+*
+* @param senderRnti the RNTI of the sender
+* @param destinationRnti the RNTI of the destination
+* @param rssiDbm the received power in dBm
+*/
+typedef Callback< void, uint16_t, uint16_t, double> MmWaveSidelinkSensingCallback;
 
 //typedef Callback< void, std::list<Ptr<MmWaveControlMessage> > > MmWavePhyRxCtrlEndOkCallback;
 
@@ -109,6 +125,22 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * TracedCallback signature for the outcome of the reception of a signal
+   *
+   * \param [in] senderRnti the RNTI of the transmitting device
+   * \param [in] destinationRnti the RNTI of the destination device
+   * \param [in] size the size of the transport block in bytes
+   */
+  typedef void (* RxOutcomeTracedCallback)(uint16_t senderRnti, uint16_t destinationRnti, uint32_t size);
+
+  /**
+   * TracedCallback signature for the SINR report of a received transport block
+   *
+   * \param [in] report information about the received transport block
+   */
+  typedef void (* SlSinrReportTracedCallback)(const SlSinrReportInfo& report);
+
   virtual void DoDispose ();
 
   void Reset ();
@@ -203,11 +235,15 @@ public:
   * @param numSym number of OFDM symbols dedicated to the TB
   * @param rnti the RNTI of the destination device
   * @param rbBitmap resource block bitmap
+  * @param harqId the HARQ process ID of the TB
+  * @param ndi the new data indicator of the TB
+  * @param rv the redundancy version of the TB, 0 for the first transmission
   *
   * @return true if an error occurred and the transmission was not
   * started, false otherwise.
   */
-  bool StartTxDataFrames (Ptr<PacketBurst> pb, Time duration, uint8_t mcs, uint32_t size, uint8_t numSym, uint16_t senderRnti, uint16_t destinationRnti, std::vector<int> rbBitmap);
+  bool StartTxDataFrames (Ptr<PacketBurst> pb, Time duration, uint8_t mcs, uint32_t size, uint8_t numSym, uint16_t senderRnti, uint16_t destinationRnti, Ptr<const MmWaveSidelinkRbMask> rbBitmap,
+                          uint8_t harqId = 0, uint8_t ndi = 0, uint8_t rv = 0);
 
   //bool StartTxControlFrames (std::list<Ptr<MmWaveControlMessage> > ctrlMsgList, Time duration);       // control frames from enb to ue
 
@@ -222,12 +258,21 @@ public:
   //void SetPhyRxCtrlEndOkCallback (MmWavePhyRxCtrlEndOkCallback c);
 
   /**
-  * Set the callback for SINR reporting
+  * Set the callback used to report the SINR to the PHY. Other consumers
+  * should connect to the SlSinrReport trace source.
   *
   * @param c the callback
   */
   void SetSidelinkSinrReportCallback (MmWaveSidelinkSinrReportCallback c);
 
+  /**
+  * Set the callback used to report the received power of each sidelink
+  * signal sensed while the device is not transmitting
+  *
+  * @param c the callback
+  */
+  void SetSidelinkSensingCallback (MmWaveSidelinkSensingCallback c);
+
   /**
   *
   *
@@ -250,7 +295,12 @@ public:
   void UpdateSinrPerceived (const SpectrumValue& sinr);
 
   /**
-  * Configure the beamforming to communicate with a specific device
+  * Configure the beamforming to communicate with a specific device. If the
+  * beam cache is enabled, the beamforming vector computed for the device is
+  * reused until the BeamCacheValidity expires, the relative position of the
+  * device changes by more than BeamCacheMaxDistance or BeamCacheMaxAngle, or
+  * the orientation of the antenna array of either device changes by more
+  * than BeamCacheMaxAngle.
   * \param dev the device we want to communicate with
   */
   void ConfigureBeamforming (Ptr<NetDevice> dev);
@@ -267,6 +317,31 @@ public:
   */
   void SetBeamformingModel (Ptr<mmwave::MmWaveBeamformingModel> beamformingModel);
 
+  /**
+  * Remove all the beamforming vectors from the beam cache
+  */
+  void ClearBeamCache ();
+
+  /**
+  * Returns the number of error model instantiations that have been avoided
+  * by reusing the error model instance owned by this object
+  * \return the number of saved allocations
+  */
+  uint64_t GetErrorModelAllocationsSaved () const;
+
+  /**
+  * Set the received power floor. Signals which are not received by this
+  * device and whose power is below the noise power by more than this value
+  * in every band are discarded without being accounted as interference.
+  * \param floorDb the power floor in dB with respect to the noise power
+  */
+  void SetRxPowerFloor (double floorDb);
+
+  /**
+  * Returns the received power floor
+  * \return the power floor in dB with respect to the noise power
+  */
+  double GetRxPowerFloor () const;
 
 private:
   /**
@@ -281,9 +356,62 @@ private:
   void EndRxData ();
   //void EndRxCtrl ();
 
+  /**
+  * Start the reception of a transport block destined to this device
+  * \param params the parameters of the signal
+  */
+  void StartRxTransportBlock (Ptr<MmWaveSidelinkSpectrumSignalParameters> params);
+
+  /**
+  * Add a signal which is not received by this device to the interference,
+  * unless its power is below the received power floor
+  * \param params the parameters of the signal
+  */
+  void AddInterferingSignal (Ptr<const SpectrumSignalParameters> params);
+
+  /**
+  * Entry of the beam cache
+  */
+  struct BeamCacheEntry
+  {
+    PhasedArrayModel::ComplexVector m_bfVector; //!< the beamforming vector
+    Vector m_relativePosition; //!< position of the other device with respect to this device when the vector was computed
+    double m_bearing; //!< bearing angle of the antenna array of this device in rad
+    double m_downtilt; //!< downtilt angle of the antenna array of this device in rad
+    double m_otherBearing; //!< bearing angle of the antenna array of the other device in rad
+    double m_otherDowntilt; //!< downtilt angle of the antenna array of the other device in rad
+    Time m_expiration; //!< time after which the vector has to be computed again
+  };
+
+  /**
+  * Check if a beamforming vector can be reused
+  * \param entry the beam cache entry
+  * \param current the relative position and the orientations of the
+  *        antenna arrays at the current time
+  * \return true if the beamforming vector is still valid
+  */
+  bool IsBeamValid (const BeamCacheEntry& entry, const BeamCacheEntry& current) const;
+
+  /**
+  * Returns the orientation of an antenna array
+  * \param array the antenna array
+  * \param bearing the bearing angle in rad, 0 if the array does not define it
+  * \param downtilt the downtilt angle in rad, 0 if the array does not define it
+  */
+  static void GetArrayOrientation (Ptr<const PhasedArrayModel> array, double& bearing, double& downtilt);
+
+  /**
+  * Returns the absolute difference between two angles
+  * \param a the first angle in rad
+  * \param b the second angle in rad
+  * \return the difference in degrees, between 0 and 180
+  */
+  static double GetAngleDifference (double a, double b);
+
   Ptr<mmwave::mmWaveInterference> m_interferenceData; ///< the data interference
   Ptr<MobilityModel> m_mobility; ///< the modility model
   Ptr<NetDevice> m_device; ///< the device
+  uint16_t m_rnti; ///< the RNTI of the device, cached when the device is set
   Ptr<SpectrumChannel> m_channel; ///< the channel
   Ptr<const SpectrumModel> m_rxSpectrumModel; ///< the spectrum model
   Ptr<SpectrumValue> m_txPsd; ///< the transmit PSD
@@ -291,6 +419,18 @@ private:
 
   std::list<TbInfo_t> m_rxTransportBlock; ///< the received with associated structure
 
+  /**
+  * State of a HARQ process of a transmitting device
+  */
+  struct HarqRxState
+  {
+    uint8_t ndi; //!< the new data indicator of the last transport block
+    mmwave::MmWaveErrorModel::MmWaveErrorModelHistory history; //!< the outputs of the error model for the failed transmissions of the transport block
+  };
+  std::map<std::pair<uint16_t, uint8_t>, HarqRxState> m_harqRxStates; ///< the HARQ state of each <sender RNTI, HARQ process ID> pair
+  MmWaveSidelinkRbMask::Bitset m_rxRbBits; ///< the RBs used by the TBs being received
+  MmWaveSidelinkRbMask::Bitset m_txRbBits; ///< the RBs used by the TBs being transmitted
+
   // Should it be MmWaveSidelinkControlMessage?
   //std::list<Ptr<MmWaveControlMessage> > m_rxControlMessageList;
 
@@ -306,7 +446,9 @@ private:
 
   //MmWavePhyRxCtrlEndOkCallback m_phyRxCtrlEndOkCallback;
   MmWavePhyRxDataEndOkCallback m_phyRxDataEndOkCallback;  ///< the mmwave sidelink phy receive data end ok callback
-  std::vector<MmWaveSidelinkSinrReportCallback> m_slSinrReportCallback; ///< the vector with mmwave sidelink SINR report callbacks
+  MmWaveSidelinkSinrReportCallback m_slSinrReportCallback; ///< the mmwave sidelink SINR report callback
+  MmWaveSidelinkSensingCallback m_slSensingCallback; ///< the mmwave sidelink sensing callback
+  TracedCallback<const SlSinrReportInfo&> m_slSinrReportTrace; ///< trace fired with the SINR report of each received TB
 
   SpectrumValue m_sinrPerceived; ///< the perceived SINR
 
@@ -320,6 +462,32 @@ private:
   //EventId m_endRxCtrlEvent;
   
   TypeId m_errorModelType; //!< the type id of the error model
+  Ptr<mmwave::MmWaveErrorModel> m_errorModel; //!< the error model instance, created once from m_errorModelType and reused for all the TBs
+  bool m_errorModelUsed; //!< true if m_errorModel has already been used for a TB
+  uint64_t m_errorModelAllocationsSaved; //!< number of error model instantiations avoided by reusing m_errorModel
+
+  double m_rxPowerFloorDb; //!< received power floor in dB with respect to the noise power
+  double m_rxPowerFloor; //!< received power floor in linear units with respect to the noise power
+  Ptr<const SpectrumValue> m_noisePsd; //!< the noise PSD, used to compare the interfering signals with the received power floor
+  TracedValue<uint64_t> m_culledSignals; //!< number of signals discarded because of the received power floor
+
+  TracedCallback<uint16_t, uint16_t, uint32_t> m_rxHalfDuplexTrace; //!< trace fired when a TB for this device is lost since the device is transmitting
+  TracedCallback<uint16_t, uint16_t, uint32_t> m_rxCollisionTrace; //!< trace fired when a TB for this device is lost since the device is receiving another TB
+  TracedCallback<uint16_t, uint16_t, uint32_t> m_rxNotForMeTrace; //!< trace fired when a TB destined to another device is discarded
+  TracedCallback<uint16_t, uint16_t, uint32_t> m_rxDecodeFailureTrace; //!< trace fired when a TB for this device is corrupted
+  TracedCallback<uint16_t, uint16_t, uint32_t> m_rxSuccessTrace; //!< trace fired when a TB for this device is correctly received
+  uint64_t m_rxHalfDuplexDrops; //!< number of TBs for this device lost since the device is transmitting
+  uint64_t m_rxCollisionDrops; //!< number of TBs for this device lost since the device is receiving another TB
+  uint64_t m_rxNotForMeDrops; //!< number of TBs destined to other devices
+  uint64_t m_rxDecodeFailures; //!< number of corrupted TBs for this device
+  uint64_t m_rxSuccesses; //!< number of TBs for this device correctly received
+
+  std::map<Ptr<NetDevice>, BeamCacheEntry> m_beamCache; //!< the beamforming vectors computed for each device
+  Time m_beamCacheValidity; //!< maximum lifetime of a cached beamforming vector, if not positive the cache is disabled
+  double m_beamCacheMaxDistance; //!< maximum displacement of the other device (in m) for a cached vector to be reused
+  double m_beamCacheMaxAngle; //!< maximum change of the direction of the other device or of the orientation of the arrays (in degrees) for a cached vector to be reused
+  uint64_t m_beamCacheHits; //!< number of beamforming vectors retrieved from the cache
+  uint64_t m_beamCacheMisses; //!< number of beamforming vectors computed by the beamforming model
 
 };
 
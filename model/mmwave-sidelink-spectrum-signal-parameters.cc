@@ -52,6 +52,9 @@ MmWaveSidelinkSpectrumSignalParameters::MmWaveSidelinkSpectrumSignalParameters (
   numSym = p.numSym;
   senderRnti = p.senderRnti;
   destinationRnti = p.destinationRnti;
+  harqId = p.harqId;
+  ndi = p.ndi;
+  rv = p.rv;
 }
 
 Ptr<SpectrumSignalParameters>
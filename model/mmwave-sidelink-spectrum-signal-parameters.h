@@ -24,6 +24,7 @@
 #define MMWAVE_SIDELINK_SPECTRUM_SIGNAL_PARAMETERS_H
 
 #include <ns3/spectrum-signal-parameters.h>
+#include "mmwave-sidelink-rb-mask.h"
 
 namespace ns3 {
 
@@ -63,7 +64,13 @@ struct MmWaveSidelinkSpectrumSignalParameters : public SpectrumSignalParameters
 
   uint32_t size; ///< the size of the corresponding transport block
 
-  std::vector<int> rbBitmap; ///< the resource blocks bitmap associated to the transport block
+  Ptr<const MmWaveSidelinkRbMask> rbBitmap; ///< the resource blocks bitmap associated to the transport block, shared among all the copies
+
+  uint8_t harqId; ///< the HARQ process ID of the transport block
+
+  uint8_t ndi; ///< the new data indicator, toggled for each new transport block of a HARQ process
+
+  uint8_t rv; ///< the redundancy version, 0 for the first transmission
 
   bool pss;
 
@@ -0,0 +1,423 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ns3/log.h>
+#include <ns3/string.h>
+#include <ns3/object-factory.h>
+#include <ns3/spectrum-model.h>
+#include "mmwave-sidelink-tabulated-error-model.h"
+#include "mmwave-sidelink-sinr-summary.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkTabulatedErrorModel");
+
+namespace millicar {
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveSidelinkTabulatedErrorModel);
+
+namespace {
+
+const char TABLE_MAGIC[8] = {'M', 'C', 'B', 'L', 'E', 'R', 'T', 'B'}; //!< identifies a BLER table file
+const uint32_t TABLE_VERSION = 1; //!< version of the file format
+
+/**
+ * Header of the BLER table file. It is followed by numTbSizes uint32_t
+ * values containing the TB sizes of the grid and by
+ * numMcs * numTbSizes * numSinr float values containing the BLER, with the
+ * SINR index running fastest.
+ */
+struct TableHeader
+{
+  char magic[8]; //!< must be equal to TABLE_MAGIC
+  uint32_t version; //!< must be equal to TABLE_VERSION
+  uint32_t numMcs; //!< number of MCS values
+  uint32_t numSinr; //!< number of SINR values
+  uint32_t numTbSizes; //!< number of TB sizes
+  double sinrMinDb; //!< first SINR value of the grid in dB
+  double sinrStepDb; //!< SINR step of the grid in dB
+  uint32_t tbSizeMin; //!< smallest TB size in bytes
+  uint32_t tbSizeStepsPerOctave; //!< number of TB sizes for each doubling of the TB size
+};
+
+/**
+ * Build a BLER table in memory
+ * \param spec the grid of the table
+ * \param referenceErrorModel the type of error model used to compute the BLER values
+ * \return the content of the table, laid out as in the file
+ */
+std::vector<uint8_t>
+BuildTable (const MmWaveSidelinkTabulatedErrorModel::TableSpec& spec, TypeId referenceErrorModel)
+{
+  NS_ABORT_MSG_IF (spec.numSinr < 2 || spec.numTbSizes < 2 || spec.numMcs == 0,
+                   "The BLER table needs at least two SINR values and two TB sizes");
+  NS_ABORT_MSG_IF (spec.sinrStepDb <= 0 || spec.tbSizeMin == 0 || spec.tbSizeStepsPerOctave == 0,
+                   "Invalid BLER table grid");
+
+  ObjectFactory factory;
+  factory.SetTypeId (referenceErrorModel);
+  Ptr<mmwave::MmWaveErrorModel> errorModel = DynamicCast<mmwave::MmWaveErrorModel> (factory.Create ());
+  NS_ABORT_MSG_IF (!errorModel, "The reference error model must be a subclass of MmWaveErrorModel");
+
+  TableHeader header;
+  std::memcpy (header.magic, TABLE_MAGIC, sizeof (TABLE_MAGIC));
+  header.version = TABLE_VERSION;
+  header.numMcs = spec.numMcs;
+  header.numSinr = spec.numSinr;
+  header.numTbSizes = spec.numTbSizes;
+  header.sinrMinDb = spec.sinrMinDb;
+  header.sinrStepDb = spec.sinrStepDb;
+  header.tbSizeMin = spec.tbSizeMin;
+  header.tbSizeStepsPerOctave = spec.tbSizeStepsPerOctave;
+
+  // logarithmically spaced TB sizes, made strictly increasing after rounding
+  std::vector<uint32_t> tbSizes (spec.numTbSizes);
+  for (uint32_t t = 0; t < spec.numTbSizes; t++)
+    {
+      double size = spec.tbSizeMin * std::pow (2.0, double (t) / spec.tbSizeStepsPerOctave);
+      tbSizes[t] = std::round (size);
+      if (t > 0 && tbSizes[t] <= tbSizes[t - 1])
+        {
+          tbSizes[t] = tbSizes[t - 1] + 1;
+        }
+    }
+
+  size_t numEntries = size_t (spec.numMcs) * spec.numTbSizes * spec.numSinr;
+  std::vector<uint8_t> buffer (sizeof (TableHeader) + tbSizes.size () * sizeof (uint32_t) + numEntries * sizeof (float));
+  std::memcpy (buffer.data (), &header, sizeof (TableHeader));
+  std::memcpy (buffer.data () + sizeof (TableHeader), tbSizes.data (), tbSizes.size () * sizeof (uint32_t));
+  float* bler = reinterpret_cast<float*> (buffer.data () + sizeof (TableHeader) + tbSizes.size () * sizeof (uint32_t));
+
+  // the SINR is flat over the TB, hence a single band is enough
+  Ptr<SpectrumModel> sm = Create<SpectrumModel> (std::vector<double> (1, 1.0));
+  SpectrumValue sinr (sm);
+  std::vector<int> map (1, 0);
+  const mmwave::MmWaveErrorModel::MmWaveErrorModelHistory history {};
+
+  for (uint32_t mcs = 0; mcs < spec.numMcs; mcs++)
+    {
+      NS_LOG_INFO ("Building the BLER table for MCS " << mcs);
+      for (uint32_t t = 0; t < spec.numTbSizes; t++)
+        {
+          for (uint32_t s = 0; s < spec.numSinr; s++)
+            {
+              double sinrDb = spec.sinrMinDb + s * spec.sinrStepDb;
+              sinr[0] = std::pow (10.0, sinrDb / 10.0);
+              Ptr<mmwave::MmWaveErrorModelOutput> output = errorModel->GetTbDecodificationStats (sinr, map, tbSizes[t], mcs, history);
+              *(bler++) = output->m_tbler;
+            }
+        }
+    }
+
+  return buffer;
+}
+
+} // anonymous namespace
+
+/**
+ * The content of a BLER table, memory-mapped from a file
+ */
+class MmWaveSidelinkTabulatedErrorModel::TableData
+{
+public:
+  /**
+   * Create a table by memory-mapping a file
+   * \param filename the name of the file
+   */
+  TableData (std::string filename);
+
+  ~TableData ();
+
+  /**
+   * Look up the BLER in the table
+   * \param sinrDb the effective SINR in dB
+   * \param mcs the MCS
+   * \param size the TB size in bytes
+   * \return the BLER, interpolated over the SINR and the TB size
+   */
+  double GetBler (double sinrDb, uint8_t mcs, uint32_t size) const;
+
+private:
+  /**
+   * Validate the content of the table and set the pointers to its sections
+   * \param data pointer to the content of the table
+   * \param length length of the table in bytes
+   */
+  void Parse (const uint8_t* data, size_t length);
+
+  /**
+   * Returns the BLER stored in the table
+   * \param mcs the MCS index
+   * \param t the TB size index
+   * \param s the SINR index
+   * \return the BLER
+   */
+  double At (uint8_t mcs, uint32_t t, uint32_t s) const
+  {
+    return m_bler[(size_t (mcs) * m_header.numTbSizes + t) * m_header.numSinr + s];
+  }
+
+  void* m_mapped; //!< the mapped region
+  size_t m_mappedLength; //!< the length of the mapped region
+  TableHeader m_header; //!< the header of the table
+  const uint32_t* m_tbSizes; //!< the TB sizes of the grid
+  const float* m_bler; //!< the BLER values
+};
+
+MmWaveSidelinkTabulatedErrorModel::TableData::TableData (std::string filename)
+  : m_mapped (nullptr),
+    m_mappedLength (0)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  NS_ABORT_MSG_IF (fd < 0, "Could not open the BLER table " << filename);
+
+  struct stat st;
+  if (fstat (fd, &st) != 0)
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Could not read the size of the BLER table " << filename);
+    }
+  m_mappedLength = st.st_size;
+
+  m_mapped = mmap (nullptr, m_mappedLength, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  NS_ABORT_MSG_IF (m_mapped == MAP_FAILED, "Could not memory-map the BLER table " << filename);
+
+  Parse (static_cast<const uint8_t*> (m_mapped), m_mappedLength);
+}
+
+MmWaveSidelinkTabulatedErrorModel::TableData::~TableData ()
+{
+  if (m_mapped)
+    {
+      munmap (m_mapped, m_mappedLength);
+    }
+}
+
+void
+MmWaveSidelinkTabulatedErrorModel::TableData::Parse (const uint8_t* data, size_t length)
+{
+  NS_ABORT_MSG_IF (length < sizeof (TableHeader), "The BLER table is too short");
+  std::memcpy (&m_header, data, sizeof (TableHeader));
+  NS_ABORT_MSG_IF (std::memcmp (m_header.magic, TABLE_MAGIC, sizeof (TABLE_MAGIC)) != 0,
+                   "The file does not contain a BLER table");
+  NS_ABORT_MSG_IF (m_header.version != TABLE_VERSION,
+                   "Unsupported BLER table version " << m_header.version);
+  NS_ABORT_MSG_IF (m_header.numSinr < 2 || m_header.numTbSizes < 2 || m_header.numMcs == 0,
+                   "Invalid BLER table grid");
+
+  size_t numEntries = size_t (m_header.numMcs) * m_header.numTbSizes * m_header.numSinr;
+  size_t expectedLength = sizeof (TableHeader) + m_header.numTbSizes * sizeof (uint32_t) + numEntries * sizeof (float);
+  NS_ABORT_MSG_IF (length != expectedLength, "The size of the BLER table does not match its header");
+
+  m_tbSizes = reinterpret_cast<const uint32_t*> (data + sizeof (TableHeader));
+  m_bler = reinterpret_cast<const float*> (data + sizeof (TableHeader) + m_header.numTbSizes * sizeof (uint32_t));
+}
+
+double
+MmWaveSidelinkTabulatedErrorModel::TableData::GetBler (double sinrDb, uint8_t mcs, uint32_t size) const
+{
+  NS_ABORT_MSG_IF (mcs >= m_header.numMcs, "MCS " << uint16_t (mcs) << " is not in the BLER table");
+
+  // position along the SINR axis
+  double x = (sinrDb - m_header.sinrMinDb) / m_header.sinrStepDb;
+  x = std::max (0.0, std::min (x, double (m_header.numSinr - 1)));
+  uint32_t s0 = std::min (uint32_t (x), m_header.numSinr - 2);
+  double ws = x - s0;
+
+  // position along the TB size axis, which is logarithmic
+  double y = std::log2 (double (std::max (size, 1u)) / m_header.tbSizeMin) * m_header.tbSizeStepsPerOctave;
+  uint32_t t0 = uint32_t (std::max (0.0, std::min (std::round (y), double (m_header.numTbSizes - 2))));
+  // the grid values are rounded, fix the index using the stored sizes
+  while (t0 > 0 && m_tbSizes[t0] > size)
+    {
+      t0--;
+    }
+  while (t0 < m_header.numTbSizes - 2 && m_tbSizes[t0 + 1] <= size)
+    {
+      t0++;
+    }
+  double wt = std::log (double (size) / m_tbSizes[t0]) / std::log (double (m_tbSizes[t0 + 1]) / m_tbSizes[t0]);
+  wt = std::max (0.0, std::min (wt, 1.0));
+
+  double b0 = (1 - ws) * At (mcs, t0, s0) + ws * At (mcs, t0, s0 + 1);
+  double b1 = (1 - ws) * At (mcs, t0 + 1, s0) + ws * At (mcs, t0 + 1, s0 + 1);
+  return (1 - wt) * b0 + wt * b1;
+}
+
+//-----------------------------------------------------------------------
+
+TypeId
+MmWaveSidelinkTabulatedErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveSidelinkTabulatedErrorModel")
+    .SetParent<mmwave::MmWaveErrorModel> ()
+    .AddConstructor<MmWaveSidelinkTabulatedErrorModel> ()
+    .AddAttribute ("TableFile",
+                   "Binary file containing the BLER table, generated with "
+                   "MmWaveSidelinkTabulatedErrorModel::GenerateTable, e.g., through "
+                   "the vehicular-bler-table-generator example. It is required, since "
+                   "building the default table takes about 660k evaluations of the "
+                   "reference error model.",
+                   StringValue (""),
+                   MakeStringAccessor (&MmWaveSidelinkTabulatedErrorModel::SetTableFile,
+                                       &MmWaveSidelinkTabulatedErrorModel::GetTableFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+MmWaveSidelinkTabulatedErrorModel::MmWaveSidelinkTabulatedErrorModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveSidelinkTabulatedErrorModel::~MmWaveSidelinkTabulatedErrorModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+/**
+ * Returns the registry of the loaded tables, indexed by file name
+ * \return the registry
+ */
+static std::map<std::string, std::shared_ptr<const MmWaveSidelinkTabulatedErrorModel::TableData>>&
+GetTableRegistry ()
+{
+  static std::map<std::string, std::shared_ptr<const MmWaveSidelinkTabulatedErrorModel::TableData>> registry;
+  return registry;
+}
+
+void
+MmWaveSidelinkTabulatedErrorModel::SetTableFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_tableFile = filename;
+  m_table = nullptr;
+
+  // map the file right away, an empty name is rejected only if the table
+  // is used, so that the attribute can be set after the construction
+  if (!m_tableFile.empty ())
+    {
+      LoadTable ();
+    }
+}
+
+std::string
+MmWaveSidelinkTabulatedErrorModel::GetTableFile () const
+{
+  return m_tableFile;
+}
+
+void
+MmWaveSidelinkTabulatedErrorModel::LoadTable ()
+{
+  NS_ABORT_MSG_IF (m_tableFile.empty (),
+                   "MmWaveSidelinkTabulatedErrorModel needs a BLER table: generate it with "
+                   "the vehicular-bler-table-generator example and set it with "
+                   "--ns3::MmWaveSidelinkTabulatedErrorModel::TableFile=<filename>");
+
+  auto& registry = GetTableRegistry ();
+  auto it = registry.find (m_tableFile);
+  if (it != registry.end ())
+    {
+      m_table = it->second;
+      return;
+    }
+
+  NS_LOG_INFO ("Memory-mapping the BLER table " << m_tableFile);
+  m_table = std::make_shared<TableData> (m_tableFile);
+  registry.insert (std::make_pair (m_tableFile, m_table));
+}
+
+double
+MmWaveSidelinkTabulatedErrorModel::GetBler (double sinrDb, uint8_t mcs, uint32_t size)
+{
+  if (!m_table)
+    {
+      LoadTable ();
+    }
+  return m_table->GetBler (sinrDb, mcs, size);
+}
+
+Ptr<mmwave::MmWaveErrorModelOutput>
+MmWaveSidelinkTabulatedErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr,
+                                                              const std::vector<int>& map,
+                                                              uint32_t size,
+                                                              uint8_t mcs,
+                                                              const MmWaveErrorModelHistory &history)
+{
+  NS_LOG_FUNCTION (this << size << uint16_t (mcs));
+  NS_ASSERT_MSG (!map.empty (), "The TB does not use any RB");
+
+  // capacity-based effective SINR over the RBs used by the TB
+  return GetTbDecodificationStatsFromEffSinr (ComputeMiesm (sinr, map), size, mcs, history);
+}
+
+Ptr<mmwave::MmWaveErrorModelOutput>
+MmWaveSidelinkTabulatedErrorModel::GetTbDecodificationStatsFromEffSinr (double effSinr,
+                                                                         uint32_t size,
+                                                                         uint8_t mcs,
+                                                                         const MmWaveErrorModelHistory &history)
+{
+  NS_LOG_FUNCTION (this << effSinr << size << uint16_t (mcs));
+
+  // chase combining with the previous transmissions of the TB
+  double combinedSinr = effSinr;
+  for (const auto& output : history)
+    {
+      Ptr<MmWaveSidelinkTabulatedErrorModelOutput> previous = DynamicCast<MmWaveSidelinkTabulatedErrorModelOutput> (output);
+      NS_ASSERT_MSG (previous, "The HARQ history was not produced by MmWaveSidelinkTabulatedErrorModel");
+      combinedSinr += previous->m_effSinr;
+    }
+
+  double bler = GetBler (10 * std::log10 (combinedSinr), mcs, size);
+  NS_LOG_DEBUG ("effective SINR " << 10 * std::log10 (effSinr) << " dB, combined with " << history.size () << " transmissions "
+                << 10 * std::log10 (combinedSinr) << " dB, MCS " << uint16_t (mcs) << ", size " << size << ", BLER " << bler);
+
+  return Create<MmWaveSidelinkTabulatedErrorModelOutput> (bler, effSinr);
+}
+
+void
+MmWaveSidelinkTabulatedErrorModel::GenerateTable (std::string filename, const TableSpec& spec, TypeId referenceErrorModel)
+{
+  NS_LOG_FUNCTION (filename);
+  std::vector<uint8_t> buffer = BuildTable (spec, referenceErrorModel);
+
+  std::ofstream file (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_IF (!file.is_open (), "Could not open " << filename);
+  file.write (reinterpret_cast<const char*> (buffer.data ()), buffer.size ());
+  NS_ABORT_MSG_IF (!file.good (), "Could not write the BLER table to " << filename);
+  file.close ();
+
+  // drop the stale mapping of a previous table with the same name
+  GetTableRegistry ().erase (filename);
+}
+
+} // namespace millicar
+
+} // namespace ns3
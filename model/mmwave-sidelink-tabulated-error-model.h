@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TABULATED_ERROR_MODEL_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TABULATED_ERROR_MODEL_H_
+
+#include <memory>
+#include <string>
+#include <ns3/mmwave-error-model.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * Output of MmWaveSidelinkTabulatedErrorModel, which also stores the
+ * effective SINR of the transmission to combine it with the retransmissions
+ */
+struct MmWaveSidelinkTabulatedErrorModelOutput : public mmwave::MmWaveErrorModelOutput
+{
+  /**
+   * Create the output
+   * \param tbler the BLER
+   * \param effSinr the effective SINR of the transmission in linear units
+   */
+  MmWaveSidelinkTabulatedErrorModelOutput (double tbler, double effSinr)
+    : MmWaveErrorModelOutput (tbler),
+      m_effSinr (effSinr)
+  {
+  }
+
+  double m_effSinr; //!< the effective SINR of the transmission in linear units
+};
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkTabulatedErrorModel
+ *
+ * Error model which looks up the BLER of a transport block in a precomputed
+ * table indexed by (MCS, TB size, effective SINR). The table is stored in a
+ * binary file which is memory-mapped when the TableFile attribute is set, and
+ * is shared among all the instances which use the same file.
+ *
+ * The effective SINR is obtained from the SINR of the RBs used by the TB
+ * through a capacity-based mapping, i.e., 2^(mean (log2 (1 + sinr))) - 1.
+ * The table is built with GenerateTable starting from a reference error
+ * model (by default MmWaveLteMiErrorModel) evaluated with a flat SINR, hence
+ * the two models return the same BLER when the SINR is flat over the TB.
+ *
+ * The TableFile attribute is required, and the simulation aborts if the
+ * table is used without it. The table with the default TableSpec, which
+ * takes about 660k evaluations of the reference error model, is generated
+ * once with the vehicular-bler-table-generator example.
+ *
+ * The retransmissions of a TB are combined with chase combining: the BLER is
+ * looked up with the sum of the effective SINRs of all the transmissions in
+ * the HARQ history. Hence, differently from MmWaveLteMiErrorModel, the gain
+ * of incremental redundancy is not modeled.
+ */
+class MmWaveSidelinkTabulatedErrorModel : public mmwave::MmWaveErrorModel
+{
+public:
+  /**
+   * Parameters of the grid used to build the BLER table
+   */
+  struct TableSpec
+  {
+    double sinrMinDb {-10.0}; //!< first SINR value of the grid in dB
+    double sinrStepDb {0.1}; //!< SINR step of the grid in dB
+    uint32_t numSinr {401}; //!< number of SINR values
+    uint32_t tbSizeMin {16}; //!< smallest TB size of the grid in bytes
+    uint32_t tbSizeStepsPerOctave {4}; //!< number of TB sizes for each doubling of the TB size
+    uint32_t numTbSizes {57}; //!< number of TB sizes
+    uint32_t numMcs {29}; //!< number of MCS values, starting from 0
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MmWaveSidelinkTabulatedErrorModel ();
+  virtual ~MmWaveSidelinkTabulatedErrorModel ();
+
+  // inherited from MmWaveErrorModel
+  Ptr<mmwave::MmWaveErrorModelOutput> GetTbDecodificationStats (const SpectrumValue& sinr,
+                                                                const std::vector<int>& map,
+                                                                uint32_t size,
+                                                                uint8_t mcs,
+                                                                const MmWaveErrorModelHistory &history) override;
+
+  /**
+   * Returns the decoding statistics of a TB given its effective SINR, so
+   * that a caller which already computed it with ComputeMiesm does not need
+   * to pass over the RBs again
+   * \param effSinr the capacity-based effective SINR of the TB in linear units
+   * \param size the TB size in bytes
+   * \param mcs the MCS
+   * \param history the outputs of the previous transmissions of the TB
+   * \return the MmWaveSidelinkTabulatedErrorModelOutput
+   */
+  Ptr<mmwave::MmWaveErrorModelOutput> GetTbDecodificationStatsFromEffSinr (double effSinr,
+                                                                          uint32_t size,
+                                                                          uint8_t mcs,
+                                                                          const MmWaveErrorModelHistory &history);
+
+  /**
+   * Look up the BLER in the table
+   * \param sinrDb the effective SINR in dB
+   * \param mcs the MCS
+   * \param size the TB size in bytes
+   * \return the BLER, interpolated over the SINR and the TB size
+   */
+  double GetBler (double sinrDb, uint8_t mcs, uint32_t size);
+
+  /**
+   * Set the file containing the BLER table and memory-map it
+   * \param filename the name of the file
+   */
+  void SetTableFile (std::string filename);
+
+  /**
+   * Returns the name of the file containing the BLER table
+   * \return the name of the file
+   */
+  std::string GetTableFile () const;
+
+  /**
+   * Build a BLER table and write it to a file which can be then loaded through
+   * the TableFile attribute
+   * \param filename the name of the output file
+   * \param spec the grid of the table
+   * \param referenceErrorModel the type of error model used to compute the BLER values
+   */
+  static void GenerateTable (std::string filename, const TableSpec& spec, TypeId referenceErrorModel);
+
+  class TableData;
+
+private:
+  /**
+   * Make sure that the table is available, mapping the file if needed
+   */
+  void LoadTable ();
+
+  std::string m_tableFile; //!< the name of the file containing the BLER table
+  std::shared_ptr<const TableData> m_table; //!< the BLER table, shared among the instances using the same file
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TABULATED_ERROR_MODEL_H_ */
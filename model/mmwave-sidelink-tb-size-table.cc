@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-sidelink-tb-size-table.h"
+#include <ns3/log.h>
+#include <ns3/mmwave-amc.h>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSidelinkTbSizeTable");
+
+namespace millicar {
+
+MmWaveSidelinkTbSizeTable::MmWaveSidelinkTbSizeTable (Ptr<mmwave::MmWavePhyMacCommon> confParams)
+  : m_phyMacConfig (confParams),
+    m_numRb (confParams->GetNumRb ()),
+    m_symPerSlot (confParams->GetSymbPerSlot ())
+{
+  NS_LOG_FUNCTION (this);
+
+  // the entry with 0 symbols is kept to simplify the indexing
+  Ptr<mmwave::MmWaveAmc> amc = CreateObject<mmwave::MmWaveAmc> (m_phyMacConfig);
+  m_tbSizes.resize (NUM_MCS * (m_symPerSlot + 1), 0);
+  for (uint8_t mcs = 0; mcs < NUM_MCS; mcs++)
+    {
+      for (uint32_t numSym = 1; numSym <= m_symPerSlot; numSym++)
+        {
+          m_tbSizes[mcs * (m_symPerSlot + 1) + numSym] = amc->CalculateTbSize (mcs, numSym);
+        }
+    }
+  amc->Dispose ();
+}
+
+Ptr<mmwave::MmWavePhyMacCommon>
+MmWaveSidelinkTbSizeTable::GetConfigurationParameters () const
+{
+  return m_phyMacConfig;
+}
+
+uint32_t
+MmWaveSidelinkTbSizeTable::GetTbSize (uint8_t mcs, uint8_t numSym, uint32_t numRbs) const
+{
+  NS_ASSERT_MSG (mcs < NUM_MCS, "Invalid MCS " << uint16_t (mcs));
+  NS_ASSERT_MSG (numSym <= m_symPerSlot, "Invalid number of symbols " << uint16_t (numSym));
+
+  uint64_t fullBandTbSize = m_tbSizes[mcs * (m_symPerSlot + 1) + numSym];
+  return fullBandTbSize * numRbs / m_numRb;
+}
+
+uint8_t
+MmWaveSidelinkTbSizeTable::GetMinNumSym (uint32_t tbSize, uint8_t mcs, uint32_t numRbs, uint8_t maxSym) const
+{
+  NS_ASSERT_MSG (mcs < NUM_MCS, "Invalid MCS " << uint16_t (mcs));
+  maxSym = std::min<uint32_t> (std::max<uint8_t> (maxSym, 1), m_symPerSlot);
+
+  // find the first number of symbols in [1, maxSym] which can carry the TB
+  auto first = m_tbSizes.begin () + mcs * (m_symPerSlot + 1) + 1;
+  auto it = std::lower_bound (first, first + maxSym, tbSize,
+                              [this, numRbs] (uint32_t fullBandTbSize, uint32_t size)
+                              {
+                                return uint64_t (fullBandTbSize) * numRbs / m_numRb < size;
+                              });
+  return it == first + maxSym ? maxSym : std::distance (first, it) + 1;
+}
+
+} // namespace millicar
+
+} // namespace ns3
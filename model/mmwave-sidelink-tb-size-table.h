@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TB_SIZE_TABLE_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TB_SIZE_TABLE_H_
+
+#include <vector>
+#include <ns3/ptr.h>
+#include <ns3/simple-ref-count.h>
+#include <ns3/mmwave-phy-mac-common.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveSidelinkTbSizeTable
+ *
+ * Table of the TB sizes returned by mmwave::MmWaveAmc for each MCS and number
+ * of symbols, using all the RBs. The table is built once, when it is
+ * created, and a single instance can be shared by all the MACs using the
+ * same mmwave::MmWavePhyMacCommon instance. If the configuration parameters
+ * are changed, a new table has to be created.
+ *
+ * The TB size of a transport block which uses only a subset of the RBs is
+ * scaled according to the fraction of RBs which are used. Since the TB size
+ * does not decrease with the number of symbols, the minimum number of
+ * symbols needed to carry a TB is found with a binary search.
+ */
+class MmWaveSidelinkTbSizeTable : public SimpleRefCount<MmWaveSidelinkTbSizeTable>
+{
+public:
+  /**
+   * Constructor, builds the table
+   * \param confParams the configuration parameters
+   */
+  MmWaveSidelinkTbSizeTable (Ptr<mmwave::MmWavePhyMacCommon> confParams);
+
+  /**
+   * Returns the configuration parameters used to build the table
+   * \return the mmwave::MmWavePhyMacCommon instance
+   */
+  Ptr<mmwave::MmWavePhyMacCommon> GetConfigurationParameters () const;
+
+  /**
+   * Returns the size of a transport block
+   * \param mcs the MCS
+   * \param numSym the number of symbols, at most the number of symbols per slot
+   * \param numRbs the number of RBs
+   * \return the TB size in bytes
+   */
+  uint32_t GetTbSize (uint8_t mcs, uint8_t numSym, uint32_t numRbs) const;
+
+  /**
+   * Returns the minimum number of symbols needed to transmit a transport
+   * block
+   * \param tbSize the TB size in bytes
+   * \param mcs the MCS
+   * \param numRbs the number of RBs
+   * \param maxSym the maximum number of symbols
+   * \return the number of symbols, between 1 and maxSym
+   */
+  uint8_t GetMinNumSym (uint32_t tbSize, uint8_t mcs, uint32_t numRbs, uint8_t maxSym) const;
+
+  static const uint8_t NUM_MCS = 29; //!< the number of MCS values in the table, starting from 0
+
+private:
+  Ptr<mmwave::MmWavePhyMacCommon> m_phyMacConfig; //!< the configuration parameters
+  uint32_t m_numRb; //!< the total number of RBs
+  uint32_t m_symPerSlot; //!< the number of symbols per slot
+  std::vector<uint32_t> m_tbSizes; //!< the TB sizes using all the RBs, m_tbSizes[mcs * (m_symPerSlot + 1) + numSym]
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_SIDELINK_TB_SIZE_TABLE_H_ */
@@ -23,6 +23,7 @@
 #include <ns3/node.h>
 #include <ns3/log.h>
 #include <ns3/object-map.h>
+#include <ns3/pointer.h>
 #include <ns3/ipv4-header.h>
 #include <ns3/ipv4-l3-protocol.h>
 #include <ns3/ipv6-header.h>
@@ -76,6 +77,18 @@ TypeId MmWaveVehicularNetDevice::GetTypeId ()
                    StringValue ("LteRlcTm"),
                    MakeStringAccessor (&MmWaveVehicularNetDevice::m_rlcType),
                    MakeStringChecker ())
+    .AddAttribute ("Phy",
+                   "The PHY associated to this NetDevice",
+                   TypeId::ATTR_GET,
+                   PointerValue (),
+                   MakePointerAccessor (&MmWaveVehicularNetDevice::m_phy),
+                   MakePointerChecker<MmWaveSidelinkPhy> ())
+    .AddAttribute ("Mac",
+                   "The MAC associated to this NetDevice",
+                   TypeId::ATTR_GET,
+                   PointerValue (),
+                   MakePointerAccessor (&MmWaveVehicularNetDevice::m_mac),
+                   MakePointerChecker<MmWaveSidelinkMac> ())
   ;
 
   return tid;
@@ -325,6 +338,9 @@ MmWaveVehicularNetDevice::ActivateBearer(const uint8_t bearerId, const uint16_t
   // Call to the MAC method that created the SAP for binding the MAC instance on this node to the RLC instance just created
   m_mac->AddMacSapUser(lcid, rlc->GetLteMacSapUser());
 
+  // allocate the tx queue towards the destination in the MAC
+  m_mac->AddPeer (destRnti);
+
   Ptr<LtePdcp> pdcp = CreateObject<LtePdcp> ();
   pdcp->SetRnti (destRnti); // this is the rnti of the destination
   pdcp->SetLcId (lcid);
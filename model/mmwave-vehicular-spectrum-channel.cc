@@ -0,0 +1,351 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2009 CTTC
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "mmwave-vehicular-spectrum-channel.h"
+#include <algorithm>
+#include <cmath>
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/node.h>
+#include <ns3/net-device.h>
+#include <ns3/mobility-model.h>
+#include <ns3/angles.h>
+#include <ns3/antenna-model.h>
+#include <ns3/phased-array-model.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/spectrum-propagation-loss-model.h>
+#include <ns3/phased-array-spectrum-propagation-loss-model.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularSpectrumChannel");
+
+namespace millicar {
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveVehicularSpectrumChannel);
+
+MmWaveVehicularSpectrumChannel::MmWaveVehicularSpectrumChannel ()
+  : m_lastIndexUpdate (Seconds (0)),
+    m_indexValid (false),
+    m_skippedReceivers (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MmWaveVehicularSpectrumChannel::~MmWaveVehicularSpectrumChannel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+MmWaveVehicularSpectrumChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveVehicularSpectrumChannel")
+    .SetParent<SpectrumChannel> ()
+    .SetGroupName ("millicar")
+    .AddConstructor<MmWaveVehicularSpectrumChannel> ()
+    .AddAttribute ("MaxInterferenceDistance",
+                   "Signals are not delivered to the receivers farther than this distance (in meters) "
+                   "from the transmitter. If 0, the signals are delivered to all the receivers.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MmWaveVehicularSpectrumChannel::m_maxDistance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("IndexUpdatePeriod",
+                   "Interval between two updates of the positions of the receivers stored in the spatial index",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&MmWaveVehicularSpectrumChannel::m_indexUpdatePeriod),
+                   MakeTimeChecker ())
+    .AddAttribute ("SkippedReceivers",
+                   "Number of receivers skipped since they were beyond the maximum interference distance",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MmWaveVehicularSpectrumChannel::m_skippedReceivers),
+                   MakeUintegerChecker<uint64_t> ())
+  ;
+  return tid;
+}
+
+void
+MmWaveVehicularSpectrumChannel::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  m_phyList.clear ();
+  m_grid.clear ();
+  m_unindexed.clear ();
+  m_candidates.clear ();
+  m_spectrumModel = nullptr;
+  SpectrumChannel::DoDispose ();
+}
+
+void
+MmWaveVehicularSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  if (std::find (m_phyList.begin (), m_phyList.end (), phy) == m_phyList.end ())
+    {
+      m_phyList.push_back (phy);
+      m_indexValid = false;
+    }
+}
+
+void
+MmWaveVehicularSpectrumChannel::RemoveRx (Ptr<SpectrumPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  auto it = std::find (m_phyList.begin (), m_phyList.end (), phy);
+  if (it != m_phyList.end ())
+    {
+      m_phyList.erase (it);
+      m_indexValid = false;
+    }
+}
+
+std::size_t
+MmWaveVehicularSpectrumChannel::GetNDevices (void) const
+{
+  return m_phyList.size ();
+}
+
+Ptr<NetDevice>
+MmWaveVehicularSpectrumChannel::GetDevice (std::size_t i) const
+{
+  NS_ASSERT (i < m_phyList.size ());
+  return m_phyList.at (i)->GetDevice ();
+}
+
+uint64_t
+MmWaveVehicularSpectrumChannel::GetSkippedReceivers () const
+{
+  return m_skippedReceivers;
+}
+
+uint64_t
+MmWaveVehicularSpectrumChannel::GetCellKey (double x, double y) const
+{
+  int64_t cx = static_cast<int64_t> (std::floor (x / m_maxDistance));
+  int64_t cy = static_cast<int64_t> (std::floor (y / m_maxDistance));
+  return (static_cast<uint64_t> (cx) << 32) ^ (static_cast<uint64_t> (cy) & 0xffffffff);
+}
+
+void
+MmWaveVehicularSpectrumChannel::UpdateIndex ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // keep the allocated buckets, since the devices usually stay in the same area
+  for (auto& cell : m_grid)
+    {
+      cell.second.clear ();
+    }
+  m_unindexed.clear ();
+
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ();
+      if (mobility)
+        {
+          Vector pos = mobility->GetPosition ();
+          m_grid[GetCellKey (pos.x, pos.y)].push_back (i);
+        }
+      else
+        {
+          m_unindexed.push_back (i);
+        }
+    }
+
+  m_lastIndexUpdate = Simulator::Now ();
+  m_indexValid = true;
+}
+
+void
+MmWaveVehicularSpectrumChannel::FindCandidates (Ptr<const SpectrumPhy> txPhy)
+{
+  m_candidates.clear ();
+
+  Ptr<MobilityModel> senderMobility = txPhy->GetMobility ();
+  if (m_maxDistance <= 0 || !senderMobility)
+    {
+      // no filtering, consider all the receivers
+      for (uint32_t i = 0; i < m_phyList.size (); i++)
+        {
+          m_candidates.push_back (i);
+        }
+      return;
+    }
+
+  if (!m_indexValid || Simulator::Now () - m_lastIndexUpdate >= m_indexUpdatePeriod)
+    {
+      UpdateIndex ();
+    }
+
+  Vector txPos = senderMobility->GetPosition ();
+  int64_t cx = static_cast<int64_t> (std::floor (txPos.x / m_maxDistance));
+  int64_t cy = static_cast<int64_t> (std::floor (txPos.y / m_maxDistance));
+  for (int64_t dx = -1; dx <= 1; dx++)
+    {
+      for (int64_t dy = -1; dy <= 1; dy++)
+        {
+          uint64_t key = (static_cast<uint64_t> (cx + dx) << 32) ^ (static_cast<uint64_t> (cy + dy) & 0xffffffff);
+          auto cell = m_grid.find (key);
+          if (cell == m_grid.end ())
+            {
+              continue;
+            }
+          for (uint32_t i : cell->second)
+            {
+              // check the actual distance using the current position
+              Vector rxPos = m_phyList[i]->GetMobility ()->GetPosition ();
+              if (CalculateDistance (txPos, rxPos) <= m_maxDistance)
+                {
+                  m_candidates.push_back (i);
+                }
+            }
+        }
+    }
+  m_candidates.insert (m_candidates.end (), m_unindexed.begin (), m_unindexed.end ());
+
+  // deliver the signals in order of registration, as the other channels do
+  std::sort (m_candidates.begin (), m_candidates.end ());
+
+  m_skippedReceivers += m_phyList.size () - m_candidates.size ();
+}
+
+void
+MmWaveVehicularSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
+{
+  NS_LOG_FUNCTION (this << txParams->psd << txParams->duration << txParams->txPhy);
+  NS_ASSERT_MSG (txParams->psd, "NULL txPsd");
+  NS_ASSERT_MSG (txParams->txPhy, "NULL txPhy");
+
+  Ptr<SpectrumSignalParameters> txParamsTrace = txParams->Copy ();
+  m_txSigParamsTrace (txParamsTrace);
+
+  if (!m_spectrumModel)
+    {
+      m_spectrumModel = txParams->psd->GetSpectrumModel ();
+    }
+  else
+    {
+      // all the attached SpectrumPhy instances must use the same SpectrumModel
+      NS_ASSERT (*(txParams->psd->GetSpectrumModel ()) == *m_spectrumModel);
+    }
+
+  Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
+  Ptr<NetDevice> txNetDevice = txParams->txPhy->GetDevice ();
+
+  FindCandidates (txParams->txPhy);
+
+  for (uint32_t i : m_candidates)
+    {
+      Ptr<SpectrumPhy> rxPhy = m_phyList[i];
+      if (rxPhy == txParams->txPhy)
+        {
+          continue;
+        }
+
+      Ptr<NetDevice> rxNetDevice = rxPhy->GetDevice ();
+      if (rxNetDevice && txNetDevice && rxNetDevice->GetNode ()->GetId () == txNetDevice->GetNode ()->GetId ())
+        {
+          NS_LOG_DEBUG ("Skipping the pathloss calculation among different antennas of the same node");
+          continue;
+        }
+
+      Time delay = MicroSeconds (0);
+      Ptr<MobilityModel> receiverMobility = rxPhy->GetMobility ();
+      Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+
+      if (senderMobility && receiverMobility)
+        {
+          double pathLossDb = 0;
+          if (rxParams->txAntenna)
+            {
+              Angles txAngles (receiverMobility->GetPosition (), senderMobility->GetPosition ());
+              pathLossDb -= rxParams->txAntenna->GetGainDb (txAngles);
+            }
+          Ptr<AntennaModel> rxAntenna = DynamicCast<AntennaModel> (rxPhy->GetAntenna ());
+          if (rxAntenna)
+            {
+              Angles rxAngles (senderMobility->GetPosition (), receiverMobility->GetPosition ());
+              pathLossDb -= rxAntenna->GetGainDb (rxAngles);
+            }
+          if (m_propagationLoss)
+            {
+              pathLossDb -= m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
+            }
+          NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+          m_pathLossTrace (txParams->txPhy, rxPhy, pathLossDb);
+          if (pathLossDb > m_maxLossDb)
+            {
+              // beyond range
+              continue;
+            }
+          double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+          *(rxParams->psd) *= pathGainLinear;
+
+          if (m_spectrumPropagationLoss)
+            {
+              rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams, senderMobility, receiverMobility);
+            }
+          else if (m_phasedArraySpectrumPropagationLoss)
+            {
+              Ptr<const PhasedArrayModel> txPhasedArrayModel = DynamicCast<PhasedArrayModel> (txParams->txPhy->GetAntenna ());
+              Ptr<const PhasedArrayModel> rxPhasedArrayModel = DynamicCast<PhasedArrayModel> (rxPhy->GetAntenna ());
+              NS_ASSERT_MSG (txPhasedArrayModel && rxPhasedArrayModel,
+                             "PhasedArrayModel instances should be installed at both TX and RX SpectrumPhy");
+              rxParams->psd = m_phasedArraySpectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams,
+                                                                                                 senderMobility,
+                                                                                                 receiverMobility,
+                                                                                                 txPhasedArrayModel,
+                                                                                                 rxPhasedArrayModel);
+            }
+
+          if (m_propagationDelay)
+            {
+              delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
+            }
+        }
+
+      if (rxNetDevice)
+        {
+          // the receiver has a NetDevice, so we expect that it is attached to a Node
+          uint32_t dstNode = rxNetDevice->GetNode ()->GetId ();
+          Simulator::ScheduleWithContext (dstNode, delay, &MmWaveVehicularSpectrumChannel::StartRx, rxParams, rxPhy);
+        }
+      else
+        {
+          Simulator::Schedule (delay, &MmWaveVehicularSpectrumChannel::StartRx, rxParams, rxPhy);
+        }
+    }
+}
+
+void
+MmWaveVehicularSpectrumChannel::StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
+{
+  NS_LOG_FUNCTION (params << receiver);
+  receiver->StartRx (params);
+}
+
+} // namespace millicar
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_VEHICULAR_SPECTRUM_CHANNEL_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_VEHICULAR_SPECTRUM_CHANNEL_H_
+
+#include <unordered_map>
+#include <vector>
+#include <ns3/spectrum-channel.h>
+#include <ns3/spectrum-model.h>
+#include <ns3/nstime.h>
+
+namespace ns3 {
+
+namespace millicar {
+
+/**
+ * \ingroup mmwave
+ * \class MmWaveVehicularSpectrumChannel
+ *
+ * SpectrumChannel which delivers a signal only to the receivers located within
+ * a maximum interference distance from the transmitter. The positions of the
+ * receivers are stored in a uniform grid with cells as large as the maximum
+ * interference distance, which is rebuilt from the mobility models every
+ * IndexUpdatePeriod. For each transmission only the 3x3 cells around the
+ * transmitter are inspected, and the distance is then checked using the
+ * current positions, hence the cost of a transmission depends on the local
+ * density of the devices rather than on their total number.
+ *
+ * Since the grid is refreshed periodically, a receiver which moved into range
+ * after the last refresh may be missed if it is still registered in a far
+ * cell. Choose IndexUpdatePeriod so that the devices move much less than the
+ * maximum interference distance within a period.
+ *
+ * As in SingleModelSpectrumChannel, all the attached SpectrumPhy instances
+ * must use the same SpectrumModel. If MaxInterferenceDistance is 0 the signals
+ * are delivered to all the receivers.
+ */
+class MmWaveVehicularSpectrumChannel : public SpectrumChannel
+{
+public:
+  MmWaveVehicularSpectrumChannel ();
+  virtual ~MmWaveVehicularSpectrumChannel ();
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  // inherited from SpectrumChannel
+  virtual void StartTx (Ptr<SpectrumSignalParameters> params) override;
+  virtual void AddRx (Ptr<SpectrumPhy> phy) override;
+  virtual void RemoveRx (Ptr<SpectrumPhy> phy) override;
+
+  // inherited from Channel
+  virtual std::size_t GetNDevices (void) const override;
+  virtual Ptr<NetDevice> GetDevice (std::size_t i) const override;
+
+  /**
+   * Returns the number of receivers which have been skipped since they were
+   * beyond the maximum interference distance
+   * \return the number of skipped receivers
+   */
+  uint64_t GetSkippedReceivers () const;
+
+protected:
+  virtual void DoDispose () override;
+
+private:
+  /**
+   * Rebuild the grid with the current positions of the receivers
+   */
+  void UpdateIndex ();
+
+  /**
+   * Returns the key of the grid cell containing a position
+   * \param x the x coordinate
+   * \param y the y coordinate
+   * \return the key of the cell
+   */
+  uint64_t GetCellKey (double x, double y) const;
+
+  /**
+   * Fill m_candidates with the indexes of the receivers which may be within
+   * the maximum interference distance from the transmitter
+   * \param txPhy the transmitting SpectrumPhy
+   */
+  void FindCandidates (Ptr<const SpectrumPhy> txPhy);
+
+  /**
+   * Deliver a signal to a receiver
+   * \param params the parameters of the received signal
+   * \param receiver the receiving SpectrumPhy
+   */
+  static void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
+
+  std::vector<Ptr<SpectrumPhy> > m_phyList; //!< the attached receivers, in order of registration
+  Ptr<const SpectrumModel> m_spectrumModel; //!< the SpectrumModel used by all the receivers
+
+  double m_maxDistance; //!< maximum interference distance in meters, 0 to disable the index
+  Time m_indexUpdatePeriod; //!< interval between two updates of the grid
+  Time m_lastIndexUpdate; //!< time of the last update of the grid
+  bool m_indexValid; //!< false if the grid has to be rebuilt before being used
+
+  std::unordered_map<uint64_t, std::vector<uint32_t> > m_grid; //!< indexes of the receivers in each cell
+  std::vector<uint32_t> m_unindexed; //!< indexes of the receivers without a mobility model
+  std::vector<uint32_t> m_candidates; //!< scratch buffer with the receivers to be considered for a transmission
+
+  uint64_t m_skippedReceivers; //!< number of receivers skipped because beyond the maximum interference distance
+};
+
+} // namespace millicar
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_VEHICULAR_SPECTRUM_CHANNEL_H_ */
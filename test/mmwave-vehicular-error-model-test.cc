@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-sidelink-tabulated-error-model.h"
+#include "ns3/mmwave-lte-mi-error-model.h"
+#include "ns3/spectrum-model.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularErrorModelTestSuite");
+
+using namespace ns3;
+using namespace millicar;
+
+/**
+ * This is a test to check if the class MmWaveSidelinkTabulatedErrorModel
+ * returns the same BLER curves of the error model used to generate its table.
+ */
+class MmWaveVehicularErrorModelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularErrorModelTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularErrorModelTestCase ();
+
+private:
+
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularErrorModelTestCase::MmWaveVehicularErrorModelTestCase ()
+  : TestCase ("Check the BLER curves of the tabulated error model")
+{
+}
+
+MmWaveVehicularErrorModelTestCase::~MmWaveVehicularErrorModelTestCase ()
+{
+}
+
+void
+MmWaveVehicularErrorModelTestCase::DoRun (void)
+{
+  // build a small table from the MI error model and load it from file
+  MmWaveSidelinkTabulatedErrorModel::TableSpec spec;
+  spec.sinrMinDb = -5.0;
+  spec.sinrStepDb = 1.0;
+  spec.numSinr = 21;
+  spec.tbSizeMin = 64;
+  spec.tbSizeStepsPerOctave = 1;
+  spec.numTbSizes = 8;
+
+  std::string filename = CreateTempDirFilename ("bler-table.bin");
+  MmWaveSidelinkTabulatedErrorModel::GenerateTable (filename, spec, mmwave::MmWaveLteMiErrorModel::GetTypeId ());
+
+  Ptr<MmWaveSidelinkTabulatedErrorModel> tabulated = CreateObject<MmWaveSidelinkTabulatedErrorModel> ();
+  tabulated->SetAttribute ("TableFile", StringValue (filename));
+  Ptr<mmwave::MmWaveLteMiErrorModel> reference = CreateObject<mmwave::MmWaveLteMiErrorModel> ();
+
+  // flat SINR over several RBs
+  std::vector<double> freqs;
+  std::vector<int> map;
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    freqs.push_back (28e9 + i * 1e6);
+    map.push_back (i);
+  }
+  Ptr<SpectrumModel> sm = Create<SpectrumModel> (freqs);
+  SpectrumValue sinr (sm);
+  const mmwave::MmWaveErrorModel::MmWaveErrorModelHistory history {};
+
+  for (uint8_t mcs = 0; mcs < spec.numMcs; mcs += 4)
+  {
+    for (uint32_t size = spec.tbSizeMin; size <= 4096; size *= 2)
+    {
+      double previousBler = 1.0;
+      for (uint32_t s = 0; s < spec.numSinr; s++)
+      {
+        double sinrDb = spec.sinrMinDb + s * spec.sinrStepDb;
+        sinr = std::pow (10.0, sinrDb / 10.0);
+
+        // on the grid points the two models must match
+        double expected = reference->GetTbDecodificationStats (sinr, map, size, mcs, history)->m_tbler;
+        double actual = tabulated->GetTbDecodificationStats (sinr, map, size, mcs, history)->m_tbler;
+        NS_TEST_ASSERT_MSG_EQ_TOL (actual, expected, 1e-6, "Unexpected BLER for MCS " << uint16_t (mcs) << " size " << size << " SINR " << sinrDb << " dB");
+
+        // the curves are not increasing with the SINR
+        NS_TEST_ASSERT_MSG_LT_OR_EQ (actual, previousBler + 1e-6, "The BLER curve is increasing");
+        previousBler = actual;
+
+        // between the grid points the BLER is interpolated
+        if (s + 1 < spec.numSinr)
+        {
+          double nextBler = tabulated->GetBler (sinrDb + spec.sinrStepDb, mcs, size);
+          double middleBler = tabulated->GetBler (sinrDb + spec.sinrStepDb / 2, mcs, size);
+          NS_TEST_ASSERT_MSG_EQ_TOL (middleBler, (actual + nextBler) / 2, 1e-6, "Unexpected interpolated BLER");
+        }
+      }
+    }
+  }
+
+  // with chase combining, a retransmission with the same SINR doubles the
+  // effective SINR of the TB
+  sinr = 1.0;
+  mmwave::MmWaveErrorModel::MmWaveErrorModelHistory harqHistory;
+  harqHistory.push_back (tabulated->GetTbDecodificationStats (sinr, map, 256, 4, harqHistory));
+  double combinedBler = tabulated->GetTbDecodificationStats (sinr, map, 256, 4, harqHistory)->m_tbler;
+  NS_TEST_ASSERT_MSG_EQ_TOL (combinedBler, tabulated->GetBler (10 * std::log10 (2.0), 4, 256), 1e-6, "Unexpected BLER after the combining");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (combinedBler, harqHistory.front ()->m_tbler, "The retransmission increased the BLER");
+}
+
+/**
+ * Test suite for the class MmWaveSidelinkTabulatedErrorModel
+ */
+class MmWaveVehicularErrorModelTestSuite : public TestSuite
+{
+public:
+  MmWaveVehicularErrorModelTestSuite ();
+};
+
+MmWaveVehicularErrorModelTestSuite::MmWaveVehicularErrorModelTestSuite ()
+  : TestSuite ("mmwave-vehicular-error-model", UNIT)
+{
+  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+  AddTestCase (new MmWaveVehicularErrorModelTestCase, TestCase::QUICK);
+}
+
+static MmWaveVehicularErrorModelTestSuite MmWaveVehicularErrorModelTestSuite;
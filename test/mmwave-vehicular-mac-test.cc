@@ -0,0 +1,991 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-sidelink-mac.h"
+#include "ns3/mmwave-sidelink-sap.h"
+#include "ns3/mmwave-spectrum-value-helper.h"
+#include "ns3/lte-mac-sap.h"
+#include "ns3/lte-radio-bearer-tag.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/test.h"
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularMacTestSuite");
+
+using namespace ns3;
+using namespace millicar;
+
+/**
+ * PHY SAP provider which stores the transport blocks and the feedbacks
+ * passed by the MAC, in place of the MmWaveSidelinkPhy
+ */
+class MmWaveVehicularTestPhySapProvider : public MmWaveSidelinkPhySapProvider
+{
+public:
+  // inherited from MmWaveSidelinkPhySapProvider
+  void AddTransportBlock (Ptr<PacketBurst> pb, SlTtiAllocInfo info) override
+  {
+    m_transportBlocks.push_back (std::make_pair (pb, info));
+  }
+  void PrepareForReception (uint16_t rnti) override
+  {
+  }
+  void NotifyTrafficPending () override
+  {
+  }
+  void SendFeedback (uint16_t rnti, SlFeedbackInfo feedback) override
+  {
+    m_feedbacks.push_back (feedback);
+  }
+
+  std::vector<std::pair<Ptr<PacketBurst>, SlTtiAllocInfo>> m_transportBlocks; //!< the transport blocks passed by the MAC
+  std::vector<SlFeedbackInfo> m_feedbacks; //!< the feedbacks sent by the MAC
+};
+
+/**
+ * MAC SAP user which answers each transmission opportunity with a PDU of
+ * the granted size, in place of the RLC
+ */
+class MmWaveVehicularTestMacSapUser : public LteMacSapUser
+{
+public:
+  /**
+   * Constructor
+   * \param provider the MAC SAP provider of the MAC
+   */
+  MmWaveVehicularTestMacSapUser (LteMacSapProvider* provider)
+    : m_provider (provider)
+  {
+  }
+
+  // inherited from LteMacSapUser
+  void NotifyTxOpportunity (TxOpportunityParameters params) override
+  {
+    LteMacSapProvider::TransmitPduParameters pduParams;
+    pduParams.pdu = Create<Packet> (params.bytes);
+    pduParams.rnti = params.rnti;
+    pduParams.lcid = params.lcid;
+    pduParams.layer = params.layer;
+    pduParams.harqProcessId = params.harqId;
+    pduParams.componentCarrierId = params.componentCarrierId;
+    m_provider->TransmitPdu (pduParams);
+  }
+  void NotifyHarqDeliveryFailure () override
+  {
+  }
+  void ReceivePdu (ReceivePduParameters params) override
+  {
+  }
+
+private:
+  LteMacSapProvider* m_provider; //!< the MAC SAP provider of the MAC
+};
+
+/**
+ * Base class of the test cases which drive a single MmWaveSidelinkMac
+ * through its SAPs. The MAC has RNTI 1 and a single logical channel
+ * towards the device with RNTI 2, which is always backlogged.
+ */
+class MmWaveVehicularMacTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param name the name of the test case
+   */
+  MmWaveVehicularMacTestCase (std::string name);
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularMacTestCase ();
+
+protected:
+  /**
+   * Create the MAC and connect it to the test SAPs
+   * \param pmc the configuration parameters
+   */
+  void SetupMac (Ptr<mmwave::MmWavePhyMacCommon> pmc);
+
+  /**
+   * Destroy the MAC and the test SAPs
+   */
+  void TeardownMac ();
+
+  /**
+   * Report the buffer status of a logical channel to the MAC
+   * \param txQueueSize the bytes waiting to be transmitted, by default the
+   *        logical channel is backlogged
+   * \param lcid the logical channel ID, by default the one created by SetupMac
+   */
+  void ReportBufferStatus (uint32_t txQueueSize = 10000000, uint8_t lcid = LCID);
+
+  /**
+   * Trigger a slot of the MAC
+   * \param sfn the slot
+   */
+  void SlotIndication (mmwave::SfnSf sfn);
+
+  static constexpr uint16_t TX_RNTI = 1; //!< the RNTI of the MAC
+  static constexpr uint16_t RX_RNTI = 2; //!< the RNTI of the destination
+  static constexpr uint8_t LCID = 3; //!< the logical channel ID
+
+  Ptr<MmWaveSidelinkMac> m_mac; //!< the MAC
+  MmWaveVehicularTestPhySapProvider* m_phySapProvider; //!< the test PHY SAP provider
+  MmWaveVehicularTestMacSapUser* m_macSapUser; //!< the test MAC SAP user
+};
+
+MmWaveVehicularMacTestCase::MmWaveVehicularMacTestCase (std::string name)
+  : TestCase (name),
+    m_phySapProvider (nullptr),
+    m_macSapUser (nullptr)
+{
+}
+
+MmWaveVehicularMacTestCase::~MmWaveVehicularMacTestCase ()
+{
+}
+
+void
+MmWaveVehicularMacTestCase::SetupMac (Ptr<mmwave::MmWavePhyMacCommon> pmc)
+{
+  m_mac = CreateObject<MmWaveSidelinkMac> (pmc);
+  m_mac->SetRnti (TX_RNTI);
+  m_phySapProvider = new MmWaveVehicularTestPhySapProvider ();
+  m_mac->SetPhySapProvider (m_phySapProvider);
+  m_macSapUser = new MmWaveVehicularTestMacSapUser (m_mac->GetMacSapProvider ());
+  m_mac->AddMacSapUser (LCID, m_macSapUser);
+  m_mac->AddPeer (RX_RNTI);
+}
+
+void
+MmWaveVehicularMacTestCase::TeardownMac ()
+{
+  m_mac->Dispose ();
+  m_mac = nullptr;
+  delete m_phySapProvider;
+  delete m_macSapUser;
+  Simulator::Destroy ();
+}
+
+void
+MmWaveVehicularMacTestCase::ReportBufferStatus (uint32_t txQueueSize, uint8_t lcid)
+{
+  LteMacSapProvider::ReportBufferStatusParameters params;
+  params.rnti = RX_RNTI;
+  params.lcid = lcid;
+  params.txQueueSize = txQueueSize;
+  params.txQueueHolDelay = 0;
+  params.retxQueueSize = 0;
+  params.retxQueueHolDelay = 0;
+  params.statusPduSize = 0;
+  m_mac->GetMacSapProvider ()->ReportBufferStatus (params);
+}
+
+void
+MmWaveVehicularMacTestCase::SlotIndication (mmwave::SfnSf sfn)
+{
+  // keep the logical channel backlogged
+  ReportBufferStatus ();
+  m_mac->GetPhySapUser ()->SlotIndication (sfn);
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the sensing-based resource selection. The device has to reserve
+ * the only slot which was not sensed as busy, and it has to keep the
+ * reservation until the reselection counter expires, even if the slot
+ * becomes busy.
+ */
+class MmWaveVehicularSensingTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularSensingTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSensingTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Report all the slots as busy, except one
+   * \param freeSlot the slot which is not busy
+   */
+  void SenseSlots (uint8_t freeSlot);
+
+  /**
+   * Trigger all the slots of a subframe
+   * \param sfNum the subframe number
+   */
+  void RunSubframe (uint8_t sfNum);
+
+  /**
+   * Callback sink fired when the MAC reserves a slot
+   * \param rnti the RNTI of the device
+   * \param slotNum the reserved slot
+   */
+  void ResourceSelection (uint16_t rnti, uint8_t slotNum);
+
+  uint32_t m_numSlots; //!< the number of slots per subframe
+  std::vector<uint8_t> m_selectedSlots; //!< the slots reserved by the MAC
+  std::vector<uint8_t> m_reservedBeforeExpiry; //!< the reserved slots before the expiry of the counter
+};
+
+MmWaveVehicularSensingTestCase::MmWaveVehicularSensingTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the sensing-based resource selection"),
+    m_numSlots (0)
+{
+}
+
+MmWaveVehicularSensingTestCase::~MmWaveVehicularSensingTestCase ()
+{
+}
+
+void
+MmWaveVehicularSensingTestCase::SenseSlots (uint8_t freeSlot)
+{
+  for (uint32_t slotNum = 0; slotNum < m_numSlots; slotNum++)
+  {
+    if (slotNum != freeSlot)
+    {
+      // signal exchanged by two other devices
+      m_mac->GetPhySapUser ()->SlSensingReport (mmwave::SfnSf (0, 0, slotNum), 5, 6, -50.0);
+    }
+  }
+}
+
+void
+MmWaveVehicularSensingTestCase::RunSubframe (uint8_t sfNum)
+{
+  for (uint32_t slotNum = 0; slotNum < m_numSlots; slotNum++)
+  {
+    SlotIndication (mmwave::SfnSf (0, sfNum, slotNum));
+    if (sfNum == 2 && slotNum == 0)
+    {
+      m_reservedBeforeExpiry = m_mac->GetReservedSlots ();
+    }
+  }
+}
+
+void
+MmWaveVehicularSensingTestCase::ResourceSelection (uint16_t rnti, uint8_t slotNum)
+{
+  m_selectedSlots.push_back (slotNum);
+}
+
+void
+MmWaveVehicularSensingTestCase::DoRun (void)
+{
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  m_numSlots = pmc->GetSlotsPerSubframe ();
+  NS_ASSERT_MSG (m_numSlots >= 3, "The test needs at least 3 slots per subframe");
+
+  // reserve a single slot for exactly 3 subframes
+  SetupMac (pmc);
+  m_mac->SetAttribute ("ResourceSelectionMode", EnumValue (MmWaveSidelinkMac::SENSING_BASED));
+  m_mac->SetAttribute ("NumReservedSlots", UintegerValue (1));
+  m_mac->SetAttribute ("MinCandidateRatio", DoubleValue (0.0));
+  m_mac->SetAttribute ("MinReselectionCounter", UintegerValue (3));
+  m_mac->SetAttribute ("MaxReselectionCounter", UintegerValue (3));
+  m_mac->SetAttribute ("SensingWindow", TimeValue (MilliSeconds (100)));
+  m_mac->TraceConnectWithoutContext ("ResourceSelection", MakeCallback (&MmWaveVehicularSensingTestCase::ResourceSelection, this));
+
+  // only slot 1 is free, it is used in subframes 0 and 1 and in subframe 2
+  // the counter expires
+  SenseSlots (1);
+  RunSubframe (0);
+  RunSubframe (1);
+
+  // after the sensing window, only slot 0 is free: the reservation of slot
+  // 1 is kept until the counter expires in slot 1 of subframe 2, then slot
+  // 0 is reserved
+  Simulator::Schedule (MilliSeconds (200), &MmWaveVehicularSensingTestCase::SenseSlots, this, 0);
+  Simulator::Schedule (MilliSeconds (200), &MmWaveVehicularSensingTestCase::RunSubframe, this, 2);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_selectedSlots.size (), 2, "The slots have to be selected twice");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (m_selectedSlots [0]), 1, "The device reserved a busy slot");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (m_selectedSlots [1]), 0, "The device reserved a busy slot after the reselection");
+  NS_TEST_ASSERT_MSG_EQ (m_reservedBeforeExpiry.size (), 1, "The reservation was released before the expiry of the counter");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (m_reservedBeforeExpiry [0]), 1, "The reservation changed before the expiry of the counter");
+
+  // slot 0 is reserved starting from subframe 3, hence the device
+  // transmitted only in slot 1
+  NS_TEST_ASSERT_MSG_GT (m_phySapProvider->m_transportBlocks.size (), 0, "The device did not transmit");
+  for (const auto& tb : m_phySapProvider->m_transportBlocks)
+  {
+    NS_TEST_ASSERT_MSG_EQ (uint16_t (tb.second.m_ttiIdx), 1, "Transmission in a slot which was not reserved");
+  }
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the slot utilization reported in the SchedulingInfo trace. A
+ * backlogged logical channel uses the whole slot, a logical channel with
+ * a few bytes a single symbol.
+ */
+class MmWaveVehicularSlotUtilizationTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularSlotUtilizationTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSlotUtilizationTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Callback sink fired when the MAC allocates a transport block
+   * \param info the scheduling information
+   */
+  void SchedulingInfo (SlSchedulingCallback info);
+
+  std::vector<SlSchedulingCallback> m_schedulingInfo; //!< the scheduling information of the transport blocks
+};
+
+MmWaveVehicularSlotUtilizationTestCase::MmWaveVehicularSlotUtilizationTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the slot utilization reported by the MAC")
+{
+}
+
+MmWaveVehicularSlotUtilizationTestCase::~MmWaveVehicularSlotUtilizationTestCase ()
+{
+}
+
+void
+MmWaveVehicularSlotUtilizationTestCase::SchedulingInfo (SlSchedulingCallback info)
+{
+  m_schedulingInfo.push_back (info);
+}
+
+void
+MmWaveVehicularSlotUtilizationTestCase::DoRun (void)
+{
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  SetupMac (pmc);
+  std::vector<uint16_t> pattern (pmc->GetSlotsPerSubframe (), RX_RNTI);
+  pattern [0] = TX_RNTI;
+  m_mac->SetSfAllocationInfo (pattern);
+  m_mac->TraceConnectWithoutContext ("SchedulingInfo", MakeCallback (&MmWaveVehicularSlotUtilizationTestCase::SchedulingInfo, this));
+
+  // backlogged logical channel
+  SlotIndication (mmwave::SfnSf (0, 0, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_schedulingInfo.size (), 1u, "Unexpected number of transport blocks");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (m_schedulingInfo [0].numSym), pmc->GetSymbPerSlot (), "Symbols left idle");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_schedulingInfo [0].slotUtilization, 1.0, 1e-9, "Unexpected slot utilization");
+
+  // a few bytes fit in a single symbol
+  ReportBufferStatus (10);
+  m_mac->GetPhySapUser ()->SlotIndication (mmwave::SfnSf (0, 1, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_schedulingInfo.size (), 2u, "Unexpected number of transport blocks");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (m_schedulingInfo [1].numSym), 1u, "Unexpected number of symbols");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_schedulingInfo [1].slotUtilization, 1.0 / pmc->GetSymbPerSlot (), 1e-9, "Unexpected slot utilization");
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the HARQ processes of the transmitter. All the slots are assigned
+ * to the device and each TB occupies the whole slot, hence a slot carries
+ * either a retransmission or a new TB. The feedback of each TB is scripted:
+ * a NACKed TB has to be retransmitted with the same PDUs, HARQ process and
+ * NDI and with an increasing RV, until MaxHarqRetransmissions is reached;
+ * a new TB has to toggle the NDI of its HARQ process; a TB without feedback
+ * has to be retransmitted after two slots.
+ */
+class MmWaveVehicularHarqTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularHarqTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularHarqTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Trigger a slot and check the TB sent by the MAC
+   * \param slot the index of the slot
+   */
+  void RunSlot (uint32_t slot);
+
+  /**
+   * Check the HARQ information of a TB
+   * \param slot the index of the slot which carried the TB
+   * \param retxOf the index of the slot which carried the first
+   *        transmission of the TB, or the same slot for a new TB
+   * \param harqId the expected HARQ process ID
+   * \param rv the expected redundancy version
+   */
+  void CheckTb (uint32_t slot, uint32_t retxOf, uint8_t harqId, uint8_t rv);
+
+  /**
+   * Send the feedback of a TB
+   * \param slot the index of the slot which carried the TB
+   * \param ack true for an ACK, false for a NACK
+   */
+  void SendFeedback (uint32_t slot, bool ack);
+
+  uint32_t m_numSlots; //!< the number of slots per subframe
+  Time m_slotPeriod; //!< the duration of a slot
+};
+
+MmWaveVehicularHarqTestCase::MmWaveVehicularHarqTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the HARQ retransmissions of the MAC"),
+    m_numSlots (0)
+{
+}
+
+MmWaveVehicularHarqTestCase::~MmWaveVehicularHarqTestCase ()
+{
+}
+
+void
+MmWaveVehicularHarqTestCase::RunSlot (uint32_t slot)
+{
+  SlotIndication (mmwave::SfnSf (0, slot / m_numSlots, slot % m_numSlots));
+}
+
+void
+MmWaveVehicularHarqTestCase::CheckTb (uint32_t slot, uint32_t retxOf, uint8_t harqId, uint8_t rv)
+{
+  const auto& tbs = m_phySapProvider->m_transportBlocks;
+  NS_TEST_ASSERT_MSG_GT (tbs.size (), slot, "No TB sent in slot " << slot);
+  const SlTtiAllocInfo& info = tbs [slot].second;
+  NS_TEST_EXPECT_MSG_EQ (uint16_t (info.m_dci.m_harqProcess), uint16_t (harqId), "Wrong HARQ process ID in slot " << slot);
+  NS_TEST_EXPECT_MSG_EQ (uint16_t (info.m_dci.m_rv), uint16_t (rv), "Wrong RV in slot " << slot);
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (info.m_dci.m_symStart), 0u, "The TB does not start from the first symbol in slot " << slot);
+  if (retxOf != slot)
+  {
+    const SlTtiAllocInfo& first = tbs [retxOf].second;
+    NS_TEST_EXPECT_MSG_EQ (tbs [slot].first, tbs [retxOf].first, "The retransmission in slot " << slot << " does not carry the same PDUs");
+    NS_TEST_EXPECT_MSG_EQ (uint16_t (info.m_dci.m_ndi), uint16_t (first.m_dci.m_ndi), "The NDI changed in the retransmission in slot " << slot);
+    NS_TEST_EXPECT_MSG_EQ (info.m_dci.m_tbSize, first.m_dci.m_tbSize, "The TB size changed in the retransmission in slot " << slot);
+    NS_TEST_EXPECT_MSG_EQ (uint16_t (info.m_dci.m_mcs), uint16_t (first.m_dci.m_mcs), "The MCS changed in the retransmission in slot " << slot);
+  }
+}
+
+void
+MmWaveVehicularHarqTestCase::SendFeedback (uint32_t slot, bool ack)
+{
+  SlFeedbackInfo feedback;
+  feedback.rnti = RX_RNTI;
+  feedback.sinrDb = 10.0;
+  feedback.ack = ack;
+  feedback.harqId = m_phySapProvider->m_transportBlocks [slot].second.m_dci.m_harqProcess;
+  m_mac->GetPhySapUser ()->ReceiveFeedback (feedback);
+}
+
+void
+MmWaveVehicularHarqTestCase::DoRun (void)
+{
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  m_numSlots = pmc->GetSlotsPerSubframe ();
+  m_slotPeriod = pmc->GetSlotPeriod ();
+  SetupMac (pmc);
+  m_mac->SetSfAllocationInfo (std::vector<uint16_t> (m_numSlots, TX_RNTI));
+  m_mac->SetAttribute ("Harq", BooleanValue (true));
+  m_mac->SetAttribute ("MaxHarqRetransmissions", UintegerValue (2));
+
+  // slot 0: new TB, NACK
+  // slots 1 and 2: retransmissions, NACK, then the TB is discarded
+  // slot 3: new TB with the same HARQ process, ACK
+  // slot 4: new TB with the same HARQ process, no feedback
+  // slot 5: new TB with another HARQ process, ACK
+  // slot 6: retransmission of the TB of slot 4, ACK
+  // slot 7: new TB with the first HARQ process
+  const uint32_t numTbs = 8;
+  std::vector<int> feedback = {0, 0, 0, 1, -1, 1, 1, 1}; // 1 for an ACK, 0 for a NACK, -1 for no feedback
+  for (uint32_t slot = 0; slot < numTbs; slot++)
+  {
+    Simulator::Schedule (m_slotPeriod * slot, &MmWaveVehicularHarqTestCase::RunSlot, this, slot);
+    if (feedback [slot] >= 0)
+    {
+      // the feedback is received before the following slot
+      Simulator::Schedule (Seconds (m_slotPeriod.GetSeconds () * (slot + 0.5)), &MmWaveVehicularHarqTestCase::SendFeedback, this, slot, feedback [slot] == 1);
+    }
+  }
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), numTbs, "Unexpected number of TBs");
+  CheckTb (0, 0, 0, 0);
+  CheckTb (1, 0, 0, 1);
+  CheckTb (2, 0, 0, 2);
+  CheckTb (3, 3, 0, 0);
+  CheckTb (4, 4, 0, 0);
+  CheckTb (5, 5, 1, 0);
+  CheckTb (6, 4, 0, 1);
+  CheckTb (7, 7, 0, 0);
+
+  // each new TB toggles the NDI of its HARQ process
+  const auto& tbs = m_phySapProvider->m_transportBlocks;
+  NS_TEST_EXPECT_MSG_NE (uint16_t (tbs [3].second.m_dci.m_ndi), uint16_t (tbs [0].second.m_dci.m_ndi), "The NDI was not toggled after the TB was discarded");
+  NS_TEST_EXPECT_MSG_NE (uint16_t (tbs [4].second.m_dci.m_ndi), uint16_t (tbs [3].second.m_dci.m_ndi), "The NDI was not toggled after an ACK");
+  NS_TEST_EXPECT_MSG_NE (uint16_t (tbs [7].second.m_dci.m_ndi), uint16_t (tbs [4].second.m_dci.m_ndi), "The NDI was not toggled after an ACK");
+  NS_TEST_EXPECT_MSG_NE (tbs [3].first, tbs [0].first, "The discarded TB was sent again");
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the outer loop link adaptation. The feedback comes from a link
+ * which decodes a TB only if the SINR offset is at least a threshold: the
+ * offset has to converge to the threshold and the fraction of NACKs to the
+ * target BLER. If the threshold cannot be reached, the offset has to stop at
+ * OllaMaxOffset.
+ */
+class MmWaveVehicularOllaTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularOllaTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularOllaTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Send the feedback of a TB, which is decoded only if the SINR offset is
+   * at least the threshold
+   * \param threshold the threshold in dB
+   * \return true if the TB was decoded
+   */
+  bool SendFeedback (double threshold);
+
+  /**
+   * Callback sink fired when the MAC updates the SINR offset
+   * \param rnti the RNTI of the destination
+   * \param offset the SINR offset in dB
+   */
+  void SinrOffset (uint16_t rnti, double offset);
+
+  double m_offset; //!< the last SINR offset
+};
+
+MmWaveVehicularOllaTestCase::MmWaveVehicularOllaTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the convergence of the outer loop link adaptation"),
+    m_offset (0.0)
+{
+}
+
+MmWaveVehicularOllaTestCase::~MmWaveVehicularOllaTestCase ()
+{
+}
+
+bool
+MmWaveVehicularOllaTestCase::SendFeedback (double threshold)
+{
+  SlFeedbackInfo feedback;
+  feedback.rnti = RX_RNTI;
+  feedback.sinrDb = 10.0;
+  feedback.ack = m_offset >= threshold;
+  feedback.harqId = 0; // HARQ is not used
+  m_mac->GetPhySapUser ()->ReceiveFeedback (feedback);
+  return feedback.ack;
+}
+
+void
+MmWaveVehicularOllaTestCase::SinrOffset (uint16_t rnti, double offset)
+{
+  NS_TEST_EXPECT_MSG_EQ (rnti, RX_RNTI, "Offset updated for the wrong device");
+  m_offset = offset;
+}
+
+void
+MmWaveVehicularOllaTestCase::DoRun (void)
+{
+  double targetBler = 0.1;
+  double stepUp = 0.5;
+  double stepDown = stepUp * targetBler / (1 - targetBler);
+  double maxOffset = 5.0;
+
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  SetupMac (pmc);
+  std::vector<uint16_t> pattern (pmc->GetSlotsPerSubframe (), RX_RNTI);
+  pattern [0] = TX_RNTI;
+  m_mac->SetSfAllocationInfo (pattern);
+  m_mac->SetAttribute ("UseAmc", BooleanValue (true));
+  m_mac->SetAttribute ("OuterLoopLinkAdaptation", BooleanValue (true));
+  m_mac->SetAttribute ("TargetBler", DoubleValue (targetBler));
+  m_mac->SetAttribute ("OllaStepUp", DoubleValue (stepUp));
+  m_mac->SetAttribute ("OllaMaxOffset", DoubleValue (maxOffset));
+  m_mac->TraceConnectWithoutContext ("SinrOffset", MakeCallback (&MmWaveVehicularOllaTestCase::SinrOffset, this));
+
+  // report a flat SINR of 15 dB, and use the corresponding MCS for the
+  // first TB
+  Ptr<SpectrumValue> sinr = mmwave::MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (pmc, 5.0);
+  *sinr = std::pow (10, 1.5);
+  SlSinrReportInfo report;
+  report.rnti = RX_RNTI;
+  report.numSym = 0;
+  report.tbSize = 0;
+  report.mcs = 0;
+  report.sinr.mean = std::pow (10, 1.5);
+  report.sinr.meanDb = 15.0;
+  report.tbler = 0.0;
+  report.corrupt = false;
+  report.harqId = 0;
+  m_mac->GetPhySapUser ()->SlSinrReport (*sinr, report);
+  SlotIndication (mmwave::SfnSf (0, 0, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), 1u, "Unexpected number of TBs");
+  uint8_t mcs = m_phySapProvider->m_transportBlocks.back ().second.m_dci.m_mcs;
+
+  // the offset reaches the threshold in less than 100 TBs, then it stays
+  // between the threshold minus the down step and the threshold plus the
+  // up step, and a TB out of 1 / targetBler is lost
+  double threshold = 2.3;
+  for (uint32_t i = 0; i < 100; i++)
+  {
+    SendFeedback (threshold);
+  }
+  uint32_t numTbs = 1000;
+  uint32_t numNacks = 0;
+  for (uint32_t i = 0; i < numTbs; i++)
+  {
+    numNacks += SendFeedback (threshold) ? 0 : 1;
+    NS_TEST_ASSERT_MSG_GT_OR_EQ (m_offset, threshold - stepDown - 1e-9, "The offset did not converge");
+    NS_TEST_ASSERT_MSG_LT (m_offset, threshold + stepUp, "The offset did not converge");
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL (double (numNacks) / numTbs, targetBler, 0.02, "The BLER did not converge to the target");
+
+  // the offset does not exceed the maximum
+  for (uint32_t i = 0; i < 100; i++)
+  {
+    SendFeedback (2 * maxOffset);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_offset, maxOffset, 1e-9, "The offset exceeded the maximum");
+
+  // the offset is applied to the next TB, without waiting for a new report
+  SlotIndication (mmwave::SfnSf (0, 1, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), 2u, "Unexpected number of TBs");
+  NS_TEST_ASSERT_MSG_LT (m_phySapProvider->m_transportBlocks.back ().second.m_dci.m_mcs, mcs, "The NACKs did not lower the MCS");
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the closed-loop power control. The tx power has to start from
+ * MaxTxPower, move by TxPowerStep towards the TargetSinr, stay within
+ * [MinTxPower, MaxTxPower], and be used for the following TBs. On a link with
+ * a fixed path loss it has to settle where the SINR is between the target
+ * and the target plus one step.
+ */
+class MmWaveVehicularPowerControlTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularPowerControlTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularPowerControlTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Send the feedback of a TB
+   * \param sinrDb the SINR of the TB in dB
+   */
+  void SendFeedback (double sinrDb);
+
+  /**
+   * Callback sink fired when the MAC updates the tx power
+   * \param rnti the RNTI of the destination
+   * \param txPower the tx power in dBm
+   */
+  void TxPower (uint16_t rnti, double txPower);
+
+  double m_txPower; //!< the last tx power
+};
+
+MmWaveVehicularPowerControlTestCase::MmWaveVehicularPowerControlTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the steps of the power control"),
+    m_txPower (0.0)
+{
+}
+
+MmWaveVehicularPowerControlTestCase::~MmWaveVehicularPowerControlTestCase ()
+{
+}
+
+void
+MmWaveVehicularPowerControlTestCase::SendFeedback (double sinrDb)
+{
+  SlFeedbackInfo feedback;
+  feedback.rnti = RX_RNTI;
+  feedback.sinrDb = sinrDb;
+  feedback.ack = true;
+  feedback.harqId = 0; // HARQ is not used
+  m_mac->GetPhySapUser ()->ReceiveFeedback (feedback);
+}
+
+void
+MmWaveVehicularPowerControlTestCase::TxPower (uint16_t rnti, double txPower)
+{
+  NS_TEST_EXPECT_MSG_EQ (rnti, RX_RNTI, "Tx power updated for the wrong device");
+  m_txPower = txPower;
+}
+
+void
+MmWaveVehicularPowerControlTestCase::DoRun (void)
+{
+  double targetSinr = 10.0;
+  double step = 1.0;
+  double minTxPower = 20.0;
+  double maxTxPower = 30.0;
+
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  SetupMac (pmc);
+  std::vector<uint16_t> pattern (pmc->GetSlotsPerSubframe (), RX_RNTI);
+  pattern [0] = TX_RNTI;
+  m_mac->SetSfAllocationInfo (pattern);
+  m_mac->SetAttribute ("TxPowerControl", BooleanValue (true));
+  m_mac->SetAttribute ("TargetSinr", DoubleValue (targetSinr));
+  m_mac->SetAttribute ("TxPowerStep", DoubleValue (step));
+  m_mac->SetAttribute ("MinTxPower", DoubleValue (minTxPower));
+  m_mac->SetAttribute ("MaxTxPower", DoubleValue (maxTxPower));
+  m_mac->TraceConnectWithoutContext ("TxPower", MakeCallback (&MmWaveVehicularPowerControlTestCase::TxPower, this));
+
+  // the maximum power is used before the first feedback
+  SlotIndication (mmwave::SfnSf (0, 0, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), 1u, "Unexpected number of TBs");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_phySapProvider->m_transportBlocks.back ().second.m_txPower, maxTxPower, 1e-9, "The maximum power was not used");
+
+  // SINR below the target: the power cannot exceed the maximum
+  SendFeedback (targetSinr - 5);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, maxTxPower, 1e-9, "The power exceeded the maximum");
+
+  // SINR above the target by more than one step: one step down, which is
+  // used by the following TB
+  SendFeedback (targetSinr + 5);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, maxTxPower - step, 1e-9, "The power was not decreased by one step");
+  SlotIndication (mmwave::SfnSf (0, 1, 0));
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), 2u, "Unexpected number of TBs");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_phySapProvider->m_transportBlocks.back ().second.m_txPower, maxTxPower - step, 1e-9, "The updated power was not used");
+
+  // SINR within one step above the target: no change
+  SendFeedback (targetSinr + step / 2);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, maxTxPower - step, 1e-9, "The power changed within the dead band");
+
+  // SINR below the target: one step up
+  SendFeedback (targetSinr - step / 2);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, maxTxPower, 1e-9, "The power was not increased by one step");
+
+  // the power cannot go below the minimum
+  for (uint32_t i = 0; i < 2 * (maxTxPower - minTxPower) / step; i++)
+  {
+    SendFeedback (targetSinr + 5);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, minTxPower, 1e-9, "The power went below the minimum");
+
+  // on a link with 13.5 dB of path loss and noise the SINR is
+  // txPower - 13.5 dB, hence the power settles at 24 dBm, where the SINR
+  // is 10.5 dB
+  double loss = 13.5;
+  for (uint32_t i = 0; i < 20; i++)
+  {
+    SendFeedback (m_txPower - loss);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_txPower, 24.0, 1e-9, "The power did not converge");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (m_txPower - loss, targetSinr, "The SINR is below the target");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_txPower - loss, targetSinr + step, "The SINR is above the target");
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the assembly of the transport blocks. The grants of two logical
+ * channels towards the same device are merged in a single transport block,
+ * which carries the PDUs of both, each with its LteRadioBearerTag. The
+ * SchedulingInfo trace is fired once per grant.
+ */
+class MmWaveVehicularTbAssemblyTestCase : public MmWaveVehicularMacTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularTbAssemblyTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularTbAssemblyTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Callback sink fired when the MAC allocates a grant
+   * \param info the scheduling information
+   */
+  void SchedulingInfo (SlSchedulingCallback info);
+
+  std::vector<SlSchedulingCallback> m_schedulingInfo; //!< the scheduling information of the grants
+};
+
+MmWaveVehicularTbAssemblyTestCase::MmWaveVehicularTbAssemblyTestCase ()
+  : MmWaveVehicularMacTestCase ("Check the assembly of the PDUs of different logical channels in a TB")
+{
+}
+
+MmWaveVehicularTbAssemblyTestCase::~MmWaveVehicularTbAssemblyTestCase ()
+{
+}
+
+void
+MmWaveVehicularTbAssemblyTestCase::SchedulingInfo (SlSchedulingCallback info)
+{
+  m_schedulingInfo.push_back (info);
+}
+
+void
+MmWaveVehicularTbAssemblyTestCase::DoRun (void)
+{
+  uint8_t otherLcid = LCID + 1;
+  uint32_t bytes = 100;
+
+  Ptr<mmwave::MmWavePhyMacCommon> pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  SetupMac (pmc);
+  MmWaveVehicularTestMacSapUser otherMacSapUser (m_mac->GetMacSapProvider ());
+  m_mac->AddMacSapUser (otherLcid, &otherMacSapUser);
+  std::vector<uint16_t> pattern (pmc->GetSlotsPerSubframe (), RX_RNTI);
+  pattern [0] = TX_RNTI;
+  m_mac->SetSfAllocationInfo (pattern);
+  m_mac->TraceConnectWithoutContext ("SchedulingInfo", MakeCallback (&MmWaveVehicularTbAssemblyTestCase::SchedulingInfo, this));
+
+  // two logical channels towards the same device, which fit in the slot
+  ReportBufferStatus (bytes, LCID);
+  ReportBufferStatus (bytes, otherLcid);
+  m_mac->GetPhySapUser ()->SlotIndication (mmwave::SfnSf (0, 0, 0));
+
+  // one grant per logical channel, one after the other
+  NS_TEST_ASSERT_MSG_EQ (m_schedulingInfo.size (), 2u, "Unexpected number of grants");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (m_schedulingInfo [1].symStart), uint32_t (m_schedulingInfo [0].symStart + m_schedulingInfo [0].numSym), "The grants are not contiguous");
+
+  // a single TB which spans both grants
+  NS_TEST_ASSERT_MSG_EQ (m_phySapProvider->m_transportBlocks.size (), 1u, "The grants were not merged");
+  const auto& tb = m_phySapProvider->m_transportBlocks.front ();
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (tb.second.m_dci.m_symStart), uint32_t (m_schedulingInfo [0].symStart), "Unexpected first symbol of the TB");
+  NS_TEST_ASSERT_MSG_EQ (uint32_t (tb.second.m_dci.m_numSym), uint32_t (m_schedulingInfo [0].numSym + m_schedulingInfo [1].numSym), "Unexpected number of symbols of the TB");
+  NS_TEST_ASSERT_MSG_EQ (tb.second.m_dci.m_tbSize, uint32_t (m_schedulingInfo [0].tbSize + m_schedulingInfo [1].tbSize), "Unexpected size of the TB");
+
+  // the TB carries a PDU of each logical channel, tagged with its LCID
+  NS_TEST_ASSERT_MSG_EQ (tb.first->GetNPackets (), 2u, "Unexpected number of PDUs in the TB");
+  std::vector<uint8_t> lcids;
+  for (auto it = tb.first->Begin (); it != tb.first->End (); it++)
+  {
+    LteRadioBearerTag tag;
+    NS_TEST_ASSERT_MSG_EQ ((*it)->PeekPacketTag (tag), true, "The PDU has no LteRadioBearerTag");
+    NS_TEST_EXPECT_MSG_EQ (tag.GetRnti (), RX_RNTI, "Unexpected RNTI of the PDU");
+    NS_TEST_EXPECT_MSG_EQ ((*it)->GetSize (), bytes, "Unexpected size of the PDU");
+    lcids.push_back (tag.GetLcid ());
+  }
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (lcids [0]), uint32_t (LCID), "Unexpected LCID of the first PDU");
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (lcids [1]), uint32_t (otherLcid), "Unexpected LCID of the second PDU");
+
+  TeardownMac ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test suite for the class MmWaveSidelinkMac
+ */
+class MmWaveVehicularMacTestSuite : public TestSuite
+{
+public:
+  MmWaveVehicularMacTestSuite ();
+};
+
+MmWaveVehicularMacTestSuite::MmWaveVehicularMacTestSuite ()
+  : TestSuite ("mmwave-vehicular-mac", UNIT)
+{
+  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+  AddTestCase (new MmWaveVehicularSensingTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularSlotUtilizationTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularHarqTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularOllaTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularPowerControlTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularTbAssemblyTestCase, TestCase::QUICK);
+}
+
+static MmWaveVehicularMacTestSuite MmWaveVehicularMacTestSuite;
@@ -0,0 +1,416 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-sidelink-scheduler.h"
+#include "ns3/mmwave-sidelink-tb-size-table.h"
+#include "ns3/test.h"
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularSchedulerTestSuite");
+
+using namespace ns3;
+using namespace millicar;
+
+/**
+ * Base class of the test cases of the sidelink schedulers
+ */
+class MmWaveVehicularSchedulerTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param name the name of the test case
+   */
+  MmWaveVehicularSchedulerTestCase (std::string name);
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSchedulerTestCase ();
+
+protected:
+  /**
+   * Create a scheduler
+   * \param type the TypeId of the scheduler
+   * \return the scheduler
+   */
+  Ptr<MmWaveSidelinkScheduler> CreateScheduler (TypeId type);
+
+  /**
+   * Check that the grants are contiguous, start from the first symbol, do
+   * not exceed the available symbols and carry at least one byte
+   * \param params the input of the scheduler
+   * \param grants the grants
+   * \return the number of symbols used by the grants
+   */
+  uint32_t CheckGrants (const SlSchedulerParams& params, const std::vector<SlSchedulerGrant>& grants);
+
+  Ptr<mmwave::MmWavePhyMacCommon> m_pmc; //!< the configuration parameters
+  Ptr<MmWaveSidelinkTbSizeTable> m_tbSizeTable; //!< the TB size table
+};
+
+MmWaveVehicularSchedulerTestCase::MmWaveVehicularSchedulerTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+MmWaveVehicularSchedulerTestCase::~MmWaveVehicularSchedulerTestCase ()
+{
+}
+
+Ptr<MmWaveSidelinkScheduler>
+MmWaveVehicularSchedulerTestCase::CreateScheduler (TypeId type)
+{
+  if (!m_pmc)
+  {
+    m_pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+    m_tbSizeTable = Create<MmWaveSidelinkTbSizeTable> (m_pmc);
+  }
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  Ptr<MmWaveSidelinkScheduler> scheduler = factory.Create<MmWaveSidelinkScheduler> ();
+  scheduler->SetConfiguration (m_pmc, m_tbSizeTable);
+  return scheduler;
+}
+
+uint32_t
+MmWaveVehicularSchedulerTestCase::CheckGrants (const SlSchedulerParams& params, const std::vector<SlSchedulerGrant>& grants)
+{
+  uint32_t symStart = 0;
+  for (const SlSchedulerGrant& grant : grants)
+  {
+    NS_TEST_EXPECT_MSG_EQ (uint32_t (grant.symStart), symStart, "The grants are not contiguous");
+    NS_TEST_EXPECT_MSG_GT (uint32_t (grant.numSym), 0u, "Grant without symbols for LCID " << uint16_t (grant.lcid));
+    NS_TEST_EXPECT_MSG_GT (grant.tbSize, 0u, "Grant without bytes for LCID " << uint16_t (grant.lcid));
+    symStart += grant.numSym;
+  }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (symStart, params.availableSymbols, "The grants exceed the available symbols");
+  return symStart;
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the max-min fair allocation of MmWaveSidelinkRrScheduler. A
+ * logical channel needs a single symbol, the others are backlogged and
+ * the symbols left are not a multiple of their number. All the symbols have
+ * to be used, the logical channel with the small demand has to be fully
+ * served, the backlogged ones have to receive the same share up to one
+ * symbol, and the additional symbols have to rotate among them.
+ */
+class MmWaveVehicularRrSchedulerTestCase : public MmWaveVehicularSchedulerTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularRrSchedulerTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularRrSchedulerTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularRrSchedulerTestCase::MmWaveVehicularRrSchedulerTestCase ()
+  : MmWaveVehicularSchedulerTestCase ("Check the max-min fair allocation of the round robin scheduler")
+{
+}
+
+MmWaveVehicularRrSchedulerTestCase::~MmWaveVehicularRrSchedulerTestCase ()
+{
+}
+
+void
+MmWaveVehicularRrSchedulerTestCase::DoRun (void)
+{
+  Ptr<MmWaveSidelinkScheduler> scheduler = CreateScheduler (MmWaveSidelinkRrScheduler::GetTypeId ());
+  uint32_t numRb = m_pmc->GetNumRb ();
+  uint8_t mcs = 10;
+
+  // the symbols left by the small logical channel are not a multiple of
+  // the number of backlogged ones
+  const uint32_t numBacklogged = 3;
+  SlSchedulerParams params;
+  params.availableSymbols = m_pmc->GetSymbPerSlot ();
+  if ((params.availableSymbols - 1) % numBacklogged == 0)
+  {
+    params.availableSymbols--;
+  }
+  params.subChannelSize = 0;
+  uint32_t smallDemand = m_tbSizeTable->GetTbSize (mcs, 1, numRb);
+  params.lcs.push_back (SlSchedulerLcInfo {1, 2, mcs, smallDemand, 0});
+  for (uint8_t lcid = 2; lcid < 2 + numBacklogged; lcid++)
+  {
+    params.lcs.push_back (SlSchedulerLcInfo {lcid, 2, mcs, 10000000, 0});
+  }
+
+  uint32_t share = (params.availableSymbols - 1) / numBacklogged;
+  std::map<uint8_t, uint32_t> totalSymbols;
+  int32_t lastExtraLcid = -1; // the last logical channel which received an additional symbol in the previous slot
+  for (uint32_t slot = 0; slot < numBacklogged; slot++)
+  {
+    std::vector<SlSchedulerGrant> grants = scheduler->Schedule (params);
+    uint32_t usedSymbols = CheckGrants (params, grants);
+    NS_TEST_ASSERT_MSG_EQ (usedSymbols, params.availableSymbols, "Symbols left idle while the logical channels are backlogged");
+    NS_TEST_ASSERT_MSG_EQ (grants.size (), params.lcs.size (), "A logical channel was not served");
+
+    // the slot starts from the logical channel following the last one which
+    // received an additional symbol
+    if (lastExtraLcid >= 0)
+    {
+      uint8_t expectedFirst = lastExtraLcid == int32_t (params.lcs.back ().lcid) ? params.lcs.front ().lcid : lastExtraLcid + 1;
+      NS_TEST_ASSERT_MSG_EQ (uint16_t (grants.front ().lcid), uint16_t (expectedFirst), "The round robin did not rotate");
+    }
+
+    for (const SlSchedulerGrant& grant : grants)
+    {
+      if (grant.lcid == 1)
+      {
+        NS_TEST_ASSERT_MSG_EQ (uint32_t (grant.numSym), 1u, "The small logical channel received more than its demand");
+        NS_TEST_ASSERT_MSG_EQ (grant.tbSize, smallDemand, "The small logical channel was not fully served");
+      }
+      else
+      {
+        NS_TEST_ASSERT_MSG_EQ ((grant.numSym == share || grant.numSym == share + 1), true, "Unfair share for LCID " << uint16_t (grant.lcid));
+        if (grant.numSym == share + 1)
+        {
+          lastExtraLcid = grant.lcid;
+        }
+      }
+      totalSymbols [grant.lcid] += grant.numSym;
+    }
+  }
+
+  // after a number of slots equal to the number of backlogged logical
+  // channels, each one received the same number of additional symbols
+  for (uint8_t lcid = 3; lcid < 2 + numBacklogged; lcid++)
+  {
+    NS_TEST_ASSERT_MSG_EQ (totalSymbols [lcid], totalSymbols [2], "The additional symbols did not rotate");
+  }
+
+  // with more backlogged logical channels than symbols, the scheduler has
+  // to terminate, use all the symbols and give at most one symbol to each
+  params.availableSymbols = 3;
+  params.lcs.clear ();
+  for (uint8_t lcid = 1; lcid <= 5; lcid++)
+  {
+    params.lcs.push_back (SlSchedulerLcInfo {lcid, 2, mcs, 10000000, 0});
+  }
+  std::vector<SlSchedulerGrant> grants = scheduler->Schedule (params);
+  NS_TEST_ASSERT_MSG_EQ (CheckGrants (params, grants), params.availableSymbols, "Symbols left idle with more logical channels than symbols");
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), params.availableSymbols, "Each symbol has to be assigned to a different logical channel");
+
+  scheduler->Dispose ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the order in which the logical channels are served by the
+ * proportional fair, max C/I and earliest deadline first schedulers
+ */
+class MmWaveVehicularSchedulerPolicyTestCase : public MmWaveVehicularSchedulerTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularSchedulerPolicyTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSchedulerPolicyTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularSchedulerPolicyTestCase::MmWaveVehicularSchedulerPolicyTestCase ()
+  : MmWaveVehicularSchedulerTestCase ("Check the policies of the PF, max C/I and EDF schedulers")
+{
+}
+
+MmWaveVehicularSchedulerPolicyTestCase::~MmWaveVehicularSchedulerPolicyTestCase ()
+{
+}
+
+void
+MmWaveVehicularSchedulerPolicyTestCase::DoRun (void)
+{
+  Ptr<MmWaveSidelinkScheduler> maxRate = CreateScheduler (MmWaveSidelinkMaxRateScheduler::GetTypeId ());
+  Ptr<MmWaveSidelinkScheduler> edf = CreateScheduler (MmWaveSidelinkEdfScheduler::GetTypeId ());
+  Ptr<MmWaveSidelinkScheduler> pf = CreateScheduler (MmWaveSidelinkPfScheduler::GetTypeId ());
+  uint32_t numRb = m_pmc->GetNumRb ();
+
+  SlSchedulerParams params;
+  params.availableSymbols = m_pmc->GetSymbPerSlot ();
+  params.subChannelSize = 0;
+
+  // max C/I: the backlogged logical channel with the best MCS takes the
+  // whole slot, when its demand is small the next best MCS is served
+  params.lcs.push_back (SlSchedulerLcInfo {1, 2, 5, 10000000, 0});
+  params.lcs.push_back (SlSchedulerLcInfo {2, 3, 20, 10000000, 0});
+  params.lcs.push_back (SlSchedulerLcInfo {3, 4, 12, 10000000, 0});
+  std::vector<SlSchedulerGrant> grants = maxRate->Schedule (params);
+  NS_TEST_ASSERT_MSG_EQ (CheckGrants (params, grants), params.availableSymbols, "Symbols left idle");
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), 1u, "Only the best MCS has to be served");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [0].lcid), 2, "The best MCS was not served");
+
+  params.lcs [1].requiredBytes = m_tbSizeTable->GetTbSize (20, 1, numRb);
+  grants = maxRate->Schedule (params);
+  NS_TEST_ASSERT_MSG_EQ (CheckGrants (params, grants), params.availableSymbols, "Symbols left idle");
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), 2u, "Unexpected number of grants");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [0].lcid), 2, "The best MCS was not served first");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [1].lcid), 3, "The second best MCS was not served");
+
+  // EDF: the logical channels are served in increasing order of deadline,
+  // the ties are broken by the MCS
+  params.lcs.clear ();
+  params.lcs.push_back (SlSchedulerLcInfo {1, 2, 20, 100, 10});
+  params.lcs.push_back (SlSchedulerLcInfo {2, 3, 5, 100, 90});
+  params.lcs.push_back (SlSchedulerLcInfo {3, 4, 12, 100, 90});
+  grants = edf->Schedule (params);
+  CheckGrants (params, grants);
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), 3u, "Unexpected number of grants");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [0].lcid), 3, "The earliest deadline with the best MCS was not served first");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [1].lcid), 2, "The earliest deadline was not served second");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [2].lcid), 1, "The latest deadline was not served last");
+
+  // PF: two backlogged logical channels with the same MCS take the whole
+  // slot in turns, since the one which is served increases its average
+  // throughput
+  params.lcs.clear ();
+  params.lcs.push_back (SlSchedulerLcInfo {1, 2, 10, 10000000, 0});
+  params.lcs.push_back (SlSchedulerLcInfo {2, 3, 10, 10000000, 0});
+  std::map<uint8_t, uint32_t> servedSlots;
+  uint8_t lastServed = 0;
+  for (uint32_t slot = 0; slot < 10; slot++)
+  {
+    grants = pf->Schedule (params);
+    NS_TEST_ASSERT_MSG_EQ (CheckGrants (params, grants), params.availableSymbols, "Symbols left idle");
+    NS_TEST_ASSERT_MSG_EQ (grants.size (), 1u, "A backlogged logical channel has to take the whole slot");
+    NS_TEST_ASSERT_MSG_NE (uint16_t (grants [0].lcid), uint16_t (lastServed), "The same logical channel was served twice in a row");
+    lastServed = grants [0].lcid;
+    servedSlots [lastServed]++;
+  }
+  NS_TEST_ASSERT_MSG_EQ (servedSlots [1], servedSlots [2], "The slots were not shared fairly");
+
+  maxRate->Dispose ();
+  edf->Dispose ();
+  pf->Dispose ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test of the split of the sub-channels. The band is divided in a large
+ * sub-channel and in a sub-channel of a single RB, which cannot carry any
+ * data in a single symbol. With two backlogged logical channels, the small
+ * sub-channel must not be left idle: the first logical channel has to be
+ * served on the whole band.
+ */
+class MmWaveVehicularSubChannelSchedulerTestCase : public MmWaveVehicularSchedulerTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularSubChannelSchedulerTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSubChannelSchedulerTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularSubChannelSchedulerTestCase::MmWaveVehicularSubChannelSchedulerTestCase ()
+  : MmWaveVehicularSchedulerTestCase ("Check that the sub-channels too small to carry data are not left idle")
+{
+}
+
+MmWaveVehicularSubChannelSchedulerTestCase::~MmWaveVehicularSubChannelSchedulerTestCase ()
+{
+}
+
+void
+MmWaveVehicularSubChannelSchedulerTestCase::DoRun (void)
+{
+  Ptr<MmWaveSidelinkScheduler> scheduler = CreateScheduler (MmWaveSidelinkRrScheduler::GetTypeId ());
+  uint32_t numRb = m_pmc->GetNumRb ();
+  uint8_t mcs = 0;
+  NS_TEST_ASSERT_MSG_EQ (m_tbSizeTable->GetTbSize (mcs, 1, 1), 0u, "A single RB carries data in a symbol, the test is not meaningful");
+
+  SlSchedulerParams params;
+  params.availableSymbols = 1;
+  params.subChannelSize = numRb - 1;
+  params.lcs.push_back (SlSchedulerLcInfo {1, 2, mcs, 10000000, 0});
+  params.lcs.push_back (SlSchedulerLcInfo {2, 3, mcs, 10000000, 0});
+
+  std::vector<SlSchedulerGrant> grants = scheduler->Schedule (params);
+  CheckGrants (params, grants);
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), 1u, "Unexpected number of grants");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [0].lcid), 1, "Unexpected logical channel");
+  NS_TEST_ASSERT_MSG_EQ (grants [0].rbMask->GetNumRbs (), numRb, "RBs left idle");
+  NS_TEST_ASSERT_MSG_EQ (grants [0].tbSize, m_tbSizeTable->GetTbSize (mcs, 1, numRb), "Unexpected TB size");
+
+  // the logical channel which was not served comes first in the next slot
+  grants = scheduler->Schedule (params);
+  NS_TEST_ASSERT_MSG_EQ (grants.size (), 1u, "Unexpected number of grants");
+  NS_TEST_ASSERT_MSG_EQ (uint16_t (grants [0].lcid), 2, "The round robin did not rotate");
+
+  scheduler->Dispose ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Test suite for the sidelink schedulers
+ */
+class MmWaveVehicularSchedulerTestSuite : public TestSuite
+{
+public:
+  MmWaveVehicularSchedulerTestSuite ();
+};
+
+MmWaveVehicularSchedulerTestSuite::MmWaveVehicularSchedulerTestSuite ()
+  : TestSuite ("mmwave-vehicular-scheduler", UNIT)
+{
+  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+  AddTestCase (new MmWaveVehicularRrSchedulerTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularSchedulerPolicyTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularSubChannelSchedulerTestCase, TestCase::QUICK);
+}
+
+static MmWaveVehicularSchedulerTestSuite MmWaveVehicularSchedulerTestSuite;
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+*   Copyright (c) 2020 University of Padova, Dep. of Information Engineering,
+*   SIGNET lab.
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License version 2 as
+*   published by the Free Software Foundation;
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program; if not, write to the Free Software
+*   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "ns3/mmwave-vehicular-spectrum-channel.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/spectrum-value.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularSpectrumChannelTestSuite");
+
+using namespace ns3;
+using namespace millicar;
+
+/**
+ * SpectrumPhy which only counts the received signals
+ */
+class CountingSpectrumPhy : public SpectrumPhy
+{
+public:
+  CountingSpectrumPhy () : m_rxCount (0) {}
+
+  void SetDevice (Ptr<NetDevice> d) override { m_device = d; }
+  Ptr<NetDevice> GetDevice () const override { return m_device; }
+  void SetMobility (Ptr<MobilityModel> m) override { m_mobility = m; }
+  Ptr<MobilityModel> GetMobility () const override { return m_mobility; }
+  void SetChannel (Ptr<SpectrumChannel> c) override {}
+  Ptr<const SpectrumModel> GetRxSpectrumModel () const override { return nullptr; }
+  Ptr<Object> GetAntenna () const override { return nullptr; }
+  void StartRx (Ptr<SpectrumSignalParameters> params) override { m_rxCount++; }
+
+  uint32_t m_rxCount; //!< number of received signals
+
+private:
+  Ptr<NetDevice> m_device;
+  Ptr<MobilityModel> m_mobility;
+};
+
+/**
+ * This is a test to check if the class MmWaveVehicularSpectrumChannel
+ * delivers the signals only to the receivers within the maximum
+ * interference distance, also when the receivers move.
+ */
+class MmWaveVehicularSpectrumChannelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularSpectrumChannelTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSpectrumChannelTestCase ();
+
+private:
+
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * Transmit a dummy signal from the first phy
+   */
+  void Transmit ();
+
+  Ptr<MmWaveVehicularSpectrumChannel> m_channel; //!< the channel under test
+  std::vector<Ptr<CountingSpectrumPhy> > m_phys; //!< the phys attached to the channel, the first one transmits
+};
+
+MmWaveVehicularSpectrumChannelTestCase::MmWaveVehicularSpectrumChannelTestCase ()
+  : TestCase ("Check the delivery of the signals in MmWaveVehicularSpectrumChannel")
+{
+}
+
+MmWaveVehicularSpectrumChannelTestCase::~MmWaveVehicularSpectrumChannelTestCase ()
+{
+}
+
+void
+MmWaveVehicularSpectrumChannelTestCase::Transmit ()
+{
+  Ptr<SpectrumModel> sm = Create<SpectrumModel> (std::vector<double> {28e9});
+  Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+  params->duration = MicroSeconds (100);
+  params->psd = Create<SpectrumValue> (sm);
+  params->txPhy = m_phys.front ();
+  m_channel->StartTx (params);
+}
+
+void
+MmWaveVehicularSpectrumChannelTestCase::DoRun (void)
+{
+  m_channel = CreateObject<MmWaveVehicularSpectrumChannel> ();
+  m_channel->SetAttribute ("MaxInterferenceDistance", DoubleValue (100.0));
+  m_channel->SetAttribute ("IndexUpdatePeriod", TimeValue (MilliSeconds (10)));
+
+  // the first phy transmits, the others are placed at increasing distances
+  std::vector<Vector> positions {Vector (0, 0, 0), Vector (50, 0, 0), Vector (0, 90, 0),
+                                 Vector (150, 0, 0), Vector (250, 250, 0)};
+  for (auto& pos : positions)
+  {
+    Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+    mm->SetPosition (pos);
+    Ptr<CountingSpectrumPhy> phy = CreateObject<CountingSpectrumPhy> ();
+    phy->SetMobility (mm);
+    m_channel->AddRx (phy);
+    m_phys.push_back (phy);
+  }
+
+  // only the phys within 100 m receive the signal
+  Simulator::Schedule (MilliSeconds (1), &MmWaveVehicularSpectrumChannelTestCase::Transmit, this);
+
+  // move the phy at 150 m within range, it is detected after the index update
+  Simulator::Schedule (MilliSeconds (2), &MobilityModel::SetPosition, m_phys.at (3)->GetMobility (), Vector (60, 0, 0));
+  Simulator::Schedule (MilliSeconds (20), &MmWaveVehicularSpectrumChannelTestCase::Transmit, this);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_phys.at (0)->m_rxCount, 0, "The transmitter should not receive its own signal");
+  NS_TEST_ASSERT_MSG_EQ (m_phys.at (1)->m_rxCount, 2, "The phy at 50 m should receive both the signals");
+  NS_TEST_ASSERT_MSG_EQ (m_phys.at (2)->m_rxCount, 2, "The phy at 90 m should receive both the signals");
+  NS_TEST_ASSERT_MSG_EQ (m_phys.at (3)->m_rxCount, 1, "The phy should receive only the signal sent when in range");
+  NS_TEST_ASSERT_MSG_EQ (m_phys.at (4)->m_rxCount, 0, "The phy out of range should not receive any signal");
+  NS_TEST_ASSERT_MSG_EQ (m_channel->GetSkippedReceivers (), 3, "Unexpected number of skipped receivers");
+
+  m_phys.clear ();
+  m_channel = nullptr;
+}
+
+/**
+ * Test suite for the class MmWaveVehicularSpectrumChannel
+ */
+class MmWaveVehicularSpectrumChannelTestSuite : public TestSuite
+{
+public:
+  MmWaveVehicularSpectrumChannelTestSuite ();
+};
+
+MmWaveVehicularSpectrumChannelTestSuite::MmWaveVehicularSpectrumChannelTestSuite ()
+  : TestSuite ("mmwave-vehicular-spectrum-channel", UNIT)
+{
+  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+  AddTestCase (new MmWaveVehicularSpectrumChannelTestCase, TestCase::QUICK);
+}
+
+static MmWaveVehicularSpectrumChannelTestSuite MmWaveVehicularSpectrumChannelTestSuite;
@@ -23,6 +23,8 @@
 #include "ns3/isotropic-antenna-model.h"
 #include "ns3/spectrum-helper.h"
 #include "ns3/mmwave-spectrum-value-helper.h"
+#include "ns3/mmwave-error-model.h"
+#include "ns3/mmwave-sidelink-psd-cache.h"
 #include "ns3/test.h"
 
 NS_LOG_COMPONENT_DEFINE ("MmWaveVehicularSpectrumPhyTestSuite");
@@ -210,7 +212,7 @@ MmWaveVehicularSpectrumPhyTestCase1::StartTest (double dist)
   uint8_t size = 20; // size of the transport block
 
   // send the transport block through the spectrum channel
-  tx_ssp->StartTxDataFrames (pb, duration, mcs, size, numSym, 0, rxRnti, subChannelsForTx);
+  tx_ssp->StartTxDataFrames (pb, duration, mcs, size, numSym, 0, rxRnti, MmWaveSidelinkRbMask::FromIndexes (subChannelsForTx));
 
   // compute the expected SINR
   m_expectedSinr = txp + 20 * log10 (3e8 / (4 * M_PI * distance * pmc->GetCenterFrequency ())) + 114 - noiseFigure - 10 * log10 (pmc->GetBandwidth () / 1e6);
@@ -221,6 +223,474 @@ MmWaveVehicularSpectrumPhyTestCase1::StartTest (double dist)
 
 }
 
+/**
+ * Error model used to check the HARQ combining at the receiver: a single
+ * transmission of a TB is always lost, a transmission combined with the
+ * previous ones is always decoded
+ */
+class MmWaveVehicularTestErrorModel : public mmwave::MmWaveErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  // inherited from MmWaveErrorModel
+  Ptr<mmwave::MmWaveErrorModelOutput> GetTbDecodificationStats (const SpectrumValue& sinr,
+                                                                const std::vector<int>& map,
+                                                                uint32_t size,
+                                                                uint8_t mcs,
+                                                                const MmWaveErrorModelHistory &history) override
+  {
+    return Create<mmwave::MmWaveErrorModelOutput> (history.empty () ? 1.0 : 0.0);
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (MmWaveVehicularTestErrorModel);
+
+TypeId
+MmWaveVehicularTestErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveVehicularTestErrorModel")
+    .SetParent<mmwave::MmWaveErrorModel> ()
+    .AddConstructor<MmWaveVehicularTestErrorModel> ()
+  ;
+  return tid;
+}
+
+/**
+ * Base class of the test cases which send TBs between spectrum phys
+ * connected through a SpectrumChannel with the Friis propagation loss. The
+ * receiver has RNTI 1 and collects the SINR reports of the received TBs.
+ */
+class MmWaveVehicularSpectrumPhyBaseTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param name the name of the test case
+   */
+  MmWaveVehicularSpectrumPhyBaseTestCase (std::string name);
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularSpectrumPhyBaseTestCase ();
+
+protected:
+  /**
+   * Create the channel and the receiver
+   * \param position the position of the receiver
+   */
+  void SetupReceiver (Vector position);
+
+  /**
+   * Create a transmitter
+   * \param position the position of the transmitter
+   * \param txPower the tx power in dBm
+   * \param rbs the RBs used by the transmitter
+   * \return the transmitting spectrum phy
+   */
+  Ptr<MmWaveSidelinkSpectrumPhy> CreateTransmitter (Vector position, double txPower, Ptr<const MmWaveSidelinkRbMask> rbs);
+
+  /**
+   * Send a TB to the receiver
+   * \param tx the transmitting spectrum phy
+   * \param senderRnti the RNTI of the transmitter
+   * \param rbs the RBs used by the TB
+   * \param harqId the HARQ process ID
+   * \param ndi the new data indicator
+   * \param rv the redundancy version
+   */
+  void Send (Ptr<MmWaveSidelinkSpectrumPhy> tx, uint16_t senderRnti, Ptr<const MmWaveSidelinkRbMask> rbs,
+             uint8_t harqId = 0, uint8_t ndi = 0, uint8_t rv = 0);
+
+  /**
+   * Returns the SINR expected on the RBs used by a transmitter in free
+   * space, without interference
+   * \param txPower the tx power in dBm
+   * \param distance the distance between the devices in m
+   * \return the SINR in dB
+   */
+  double GetExpectedSinr (double txPower, double distance) const;
+
+  static constexpr uint16_t RX_RNTI = 1; //!< the RNTI of the receiver
+  static constexpr double NOISE_FIGURE = 5.0; //!< the noise figure of the receiver in dB
+
+  Ptr<mmwave::MmWavePhyMacCommon> m_pmc; //!< the configuration parameters
+  Ptr<MmWaveSidelinkPsdCache> m_psdCache; //!< the cache of the tx PSDs
+  Ptr<SpectrumChannel> m_channel; //!< the channel
+  Ptr<MmWaveSidelinkSpectrumPhy> m_rx; //!< the receiving spectrum phy
+  std::vector<SlSinrReportInfo> m_reports; //!< the reports of the received TBs
+
+private:
+  /**
+   * This method is a callback sink which is fired when the rx receives a packet
+   * \param p received packet
+   */
+  void Rx (Ptr<Packet> p);
+
+  /**
+   * This method is a callback sink which is fired when the rx reports the
+   * SINR of a TB
+   * \param report information about the received TB
+   */
+  void SlSinrReport (const SlSinrReportInfo& report);
+
+  /**
+   * Create a spectrum phy with an isotropic antenna and connect it to the
+   * channel
+   * \param position the position of the device
+   * \return the spectrum phy
+   */
+  Ptr<MmWaveSidelinkSpectrumPhy> CreateSpectrumPhy (Vector position);
+};
+
+MmWaveVehicularSpectrumPhyBaseTestCase::MmWaveVehicularSpectrumPhyBaseTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+MmWaveVehicularSpectrumPhyBaseTestCase::~MmWaveVehicularSpectrumPhyBaseTestCase ()
+{
+}
+
+Ptr<MmWaveSidelinkSpectrumPhy>
+MmWaveVehicularSpectrumPhyBaseTestCase::CreateSpectrumPhy (Vector position)
+{
+  Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+  mm->SetPosition (position);
+  Ptr<UniformPlanarArray> aam = CreateObject<UniformPlanarArray> ();
+  aam->SetAntennaElement (CreateObject<IsotropicAntennaModel> ());
+
+  Ptr<MmWaveSidelinkSpectrumPhy> ssp = CreateObject<MmWaveSidelinkSpectrumPhy> ();
+  ssp->SetMobility (mm);
+  ssp->SetAntenna (aam);
+  ssp->SetChannel (m_channel);
+  return ssp;
+}
+
+void
+MmWaveVehicularSpectrumPhyBaseTestCase::SetupReceiver (Vector position)
+{
+  m_pmc = CreateObject<mmwave::MmWavePhyMacCommon> ();
+  m_psdCache = Create<MmWaveSidelinkPsdCache> (m_pmc);
+  SpectrumChannelHelper sh = SpectrumChannelHelper::Default ();
+  m_channel = sh.Create ();
+
+  m_rx = CreateSpectrumPhy (position);
+  m_channel->AddRx (m_rx);
+  m_rx->SetPhyRxDataEndOkCallback (MakeCallback (&MmWaveVehicularSpectrumPhyBaseTestCase::Rx, this));
+  m_rx->TraceConnectWithoutContext ("SlSinrReport", MakeCallback (&MmWaveVehicularSpectrumPhyBaseTestCase::SlSinrReport, this));
+
+  Ptr<mmwave::mmWaveChunkProcessor> pData = Create<mmwave::mmWaveChunkProcessor> ();
+  pData->AddCallback (MakeCallback (&MmWaveSidelinkSpectrumPhy::UpdateSinrPerceived, m_rx));
+  m_rx->AddDataSinrChunkProcessor (pData);
+  m_rx->SetNoisePowerSpectralDensity (mmwave::MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_pmc, NOISE_FIGURE));
+
+  // the MmWaveSidelinkSpectrumPhy takes the RNTI from the device
+  Ptr<MmWaveSidelinkPhy> phy = CreateObject<MmWaveSidelinkPhy> (m_rx, m_pmc);
+  Ptr<MmWaveSidelinkMac> mac = CreateObject<MmWaveSidelinkMac> (m_pmc);
+  phy->SetPhySapUser (mac->GetPhySapUser ());
+  mac->SetPhySapProvider (phy->GetPhySapProvider ());
+  mac->SetRnti (RX_RNTI);
+  Ptr<MmWaveVehicularNetDevice> device = CreateObject<MmWaveVehicularNetDevice> (phy, mac);
+  NodeContainer nc;
+  nc.Create (1);
+  m_rx->SetDevice (device);
+  device->SetNode (nc.Get (0));
+  nc.Get (0)->AddDevice (device);
+}
+
+Ptr<MmWaveSidelinkSpectrumPhy>
+MmWaveVehicularSpectrumPhyBaseTestCase::CreateTransmitter (Vector position, double txPower, Ptr<const MmWaveSidelinkRbMask> rbs)
+{
+  // the tx PSD is built as in MmWaveSidelinkPhy
+  Ptr<MmWaveSidelinkSpectrumPhy> tx = CreateSpectrumPhy (position);
+  tx->SetTxPowerSpectralDensity (m_psdCache->GetTxPsd (txPower, rbs));
+  return tx;
+}
+
+void
+MmWaveVehicularSpectrumPhyBaseTestCase::Send (Ptr<MmWaveSidelinkSpectrumPhy> tx, uint16_t senderRnti, Ptr<const MmWaveSidelinkRbMask> rbs,
+                                              uint8_t harqId, uint8_t ndi, uint8_t rv)
+{
+  Ptr<PacketBurst> pb = CreateObject<PacketBurst> ();
+  pb->AddPacket (Create<Packet> (20));
+  tx->StartTxDataFrames (pb, MicroSeconds (100), 0, 20, 14, senderRnti, RX_RNTI, rbs, harqId, ndi, rv);
+}
+
+double
+MmWaveVehicularSpectrumPhyBaseTestCase::GetExpectedSinr (double txPower, double distance) const
+{
+  return txPower + 20 * log10 (3e8 / (4 * M_PI * distance * m_pmc->GetCenterFrequency ())) + 114 - NOISE_FIGURE - 10 * log10 (m_pmc->GetBandwidth () / 1e6);
+}
+
+void
+MmWaveVehicularSpectrumPhyBaseTestCase::Rx (Ptr<Packet> p)
+{
+  NS_LOG_DEBUG ("Rx event");
+}
+
+void
+MmWaveVehicularSpectrumPhyBaseTestCase::SlSinrReport (const SlSinrReportInfo& report)
+{
+  m_reports.push_back (report);
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * This is a test to check if a TB sent on a part of the band is received
+ * with the same SINR of a TB sent on the whole band with the same tx power,
+ * since the power per RB does not depend on the RBs used by the TB.
+ */
+class MmWaveVehicularPartialBandTestCase : public MmWaveVehicularSpectrumPhyBaseTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularPartialBandTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularPartialBandTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularPartialBandTestCase::MmWaveVehicularPartialBandTestCase ()
+  : MmWaveVehicularSpectrumPhyBaseTestCase ("Check the SINR of a TB sent on a part of the band")
+{
+}
+
+MmWaveVehicularPartialBandTestCase::~MmWaveVehicularPartialBandTestCase ()
+{
+}
+
+void
+MmWaveVehicularPartialBandTestCase::DoRun (void)
+{
+  double distance = 100.0;
+  double txPower = 30.0;
+  SetupReceiver (Vector (distance, 0.0, 0.0));
+
+  // a TB on the whole band, then a TB on a quarter of the band
+  Ptr<const MmWaveSidelinkRbMask> fullMask = MmWaveSidelinkRbMask::GetFullMask (m_pmc->GetNumRb ());
+  Ptr<const MmWaveSidelinkRbMask> quarterMask = MmWaveSidelinkRbMask::FromRange (0, m_pmc->GetNumRb () / 4);
+  Ptr<MmWaveSidelinkSpectrumPhy> fullTx = CreateTransmitter (Vector (0.0, 0.0, 0.0), txPower, fullMask);
+  Ptr<MmWaveSidelinkSpectrumPhy> quarterTx = CreateTransmitter (Vector (0.0, 0.0, 0.0), txPower, quarterMask);
+  Simulator::Schedule (MilliSeconds (0), &MmWaveVehicularPartialBandTestCase::Send, this, fullTx, 2, fullMask, 0, 0, 0);
+  Simulator::Schedule (MilliSeconds (1), &MmWaveVehicularPartialBandTestCase::Send, this, quarterTx, 3, quarterMask, 0, 0, 0);
+  Simulator::Stop (MilliSeconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_reports.size (), 2u, "A TB was not received");
+  double expectedSinr = GetExpectedSinr (txPower, distance);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_reports [0].sinr.meanDb, expectedSinr, 1e-2, "Unexpected SINR of the full band TB");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_reports [1].sinr.meanDb, expectedSinr, 1e-2, "Unexpected SINR of the partial band TB");
+
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * This is a test to check if the class MmWaveSidelinkSpectrumPhy receives
+ * the TBs which start at the same time on disjoint sets of RBs, each with
+ * the SINR of its own RBs, and if a TB which overlaps with the one being
+ * received is dropped and treated as interference.
+ */
+class MmWaveVehicularFdmRxTestCase : public MmWaveVehicularSpectrumPhyBaseTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularFdmRxTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularFdmRxTestCase ();
+
+private:
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * This method is a callback sink which is fired when a TB for the rx is
+   * dropped because of a collision
+   * \param senderRnti the RNTI of the transmitter
+   * \param destinationRnti the RNTI of the receiver
+   * \param size the size of the TB in bytes
+   */
+  void RxCollision (uint16_t senderRnti, uint16_t destinationRnti, uint32_t size);
+
+  std::vector<uint16_t> m_collisions; //!< the RNTIs of the transmitters of the dropped TBs
+};
+
+MmWaveVehicularFdmRxTestCase::MmWaveVehicularFdmRxTestCase ()
+  : MmWaveVehicularSpectrumPhyBaseTestCase ("Check the reception of concurrent TBs on different RBs")
+{
+}
+
+MmWaveVehicularFdmRxTestCase::~MmWaveVehicularFdmRxTestCase ()
+{
+}
+
+void
+MmWaveVehicularFdmRxTestCase::RxCollision (uint16_t senderRnti, uint16_t destinationRnti, uint32_t size)
+{
+  m_collisions.push_back (senderRnti);
+}
+
+void
+MmWaveVehicularFdmRxTestCase::DoRun (void)
+{
+  // the transmitters are at the same distance from the receiver, hence
+  // their signals arrive at the same time
+  double distance = 100.0;
+  SetupReceiver (Vector (0.0, 0.0, 0.0));
+  m_rx->TraceConnectWithoutContext ("RxCollision", MakeCallback (&MmWaveVehicularFdmRxTestCase::RxCollision, this));
+  Vector posA (distance, 0.0, 0.0);
+  Vector posB (0.0, distance, 0.0);
+
+  // two TBs on disjoint RBs and with different tx powers
+  double txPowerA = 30.0;
+  double txPowerB = 20.0;
+  uint32_t numRb = m_pmc->GetNumRb ();
+  Ptr<const MmWaveSidelinkRbMask> lowerMask = MmWaveSidelinkRbMask::FromRange (0, numRb / 2);
+  Ptr<const MmWaveSidelinkRbMask> upperMask = MmWaveSidelinkRbMask::FromRange (numRb / 2, numRb - numRb / 2);
+  Ptr<MmWaveSidelinkSpectrumPhy> txA = CreateTransmitter (posA, txPowerA, lowerMask);
+  Ptr<MmWaveSidelinkSpectrumPhy> txB = CreateTransmitter (posB, txPowerB, upperMask);
+  Simulator::Schedule (MilliSeconds (0), &MmWaveVehicularFdmRxTestCase::Send, this, txA, 2, lowerMask, 0, 0, 0);
+  Simulator::Schedule (MilliSeconds (0), &MmWaveVehicularFdmRxTestCase::Send, this, txB, 3, upperMask, 0, 0, 0);
+
+  // two TBs with the same tx power on overlapping RBs: the receiver locks
+  // onto the first one, and the second one is interference
+  Ptr<const MmWaveSidelinkRbMask> fullMask = MmWaveSidelinkRbMask::GetFullMask (numRb);
+  Ptr<MmWaveSidelinkSpectrumPhy> txC = CreateTransmitter (posA, txPowerA, fullMask);
+  Ptr<MmWaveSidelinkSpectrumPhy> txD = CreateTransmitter (posB, txPowerA, lowerMask);
+  Simulator::Schedule (MilliSeconds (1), &MmWaveVehicularFdmRxTestCase::Send, this, txC, 4, fullMask, 0, 0, 0);
+  Simulator::Schedule (MilliSeconds (1), &MmWaveVehicularFdmRxTestCase::Send, this, txD, 5, lowerMask, 0, 0, 0);
+  Simulator::Stop (MilliSeconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_reports.size (), 3u, "Unexpected number of received TBs");
+  NS_TEST_EXPECT_MSG_EQ (m_reports [0].rnti, 2, "Unexpected transmitter of the first TB");
+  NS_TEST_EXPECT_MSG_EQ (m_reports [1].rnti, 3, "Unexpected transmitter of the second TB");
+  NS_TEST_EXPECT_MSG_EQ (m_reports [0].corrupt, false, "The first concurrent TB was not decoded");
+  NS_TEST_EXPECT_MSG_EQ (m_reports [1].corrupt, false, "The second concurrent TB was not decoded");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_reports [0].sinr.meanDb, GetExpectedSinr (txPowerA, distance), 1e-2, "Unexpected SINR of the first concurrent TB");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_reports [1].sinr.meanDb, GetExpectedSinr (txPowerB, distance), 1e-2, "Unexpected SINR of the second concurrent TB");
+
+  // the TB which overlaps on the lower half of the band reduces the SINR
+  // of the received one on those RBs
+  NS_TEST_EXPECT_MSG_EQ (m_reports [2].rnti, 4, "The receiver did not lock onto the first overlapping TB");
+  NS_TEST_EXPECT_MSG_LT (m_reports [2].sinr.meanDb, GetExpectedSinr (txPowerA, distance) - 1.0, "The overlapping TB was not treated as interference");
+  NS_TEST_ASSERT_MSG_EQ (m_collisions.size (), 1u, "Unexpected number of collisions");
+  NS_TEST_EXPECT_MSG_EQ (m_collisions [0], 5, "The overlapping TB was not dropped");
+
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * This is a test to check if the class MmWaveSidelinkSpectrumPhy combines
+ * the retransmissions of a TB with the previous copies received with the
+ * same HARQ process, and if it discards them when a new TB is sent, i.e.,
+ * with RV 0 or with a toggled NDI.
+ */
+class MmWaveVehicularHarqCombiningTestCase : public MmWaveVehicularSpectrumPhyBaseTestCase
+{
+public:
+  /**
+   * Constructor
+   */
+  MmWaveVehicularHarqCombiningTestCase ();
+
+  /**
+   * Destructor
+   */
+  virtual ~MmWaveVehicularHarqCombiningTestCase ();
+
+private:
+  /**
+   * Expected outcome of the reception of a TB
+   */
+  struct Transmission
+  {
+    uint8_t harqId; //!< the HARQ process ID
+    uint8_t ndi; //!< the new data indicator
+    uint8_t rv; //!< the redundancy version
+    bool combined; //!< true if the TB has to be combined with the previous copies
+  };
+
+  /**
+   * This method run the test
+   */
+  virtual void DoRun (void);
+};
+
+MmWaveVehicularHarqCombiningTestCase::MmWaveVehicularHarqCombiningTestCase ()
+  : MmWaveVehicularSpectrumPhyBaseTestCase ("Check the HARQ combining at the receiver")
+{
+}
+
+MmWaveVehicularHarqCombiningTestCase::~MmWaveVehicularHarqCombiningTestCase ()
+{
+}
+
+void
+MmWaveVehicularHarqCombiningTestCase::DoRun (void)
+{
+  // the SINR does not matter since the outcome of each reception is
+  // decided by MmWaveVehicularTestErrorModel
+  SetupReceiver (Vector (100.0, 0.0, 0.0));
+  m_rx->SetAttribute ("ErrorModelType", TypeIdValue (MmWaveVehicularTestErrorModel::GetTypeId ()));
+  Ptr<const MmWaveSidelinkRbMask> rbs = MmWaveSidelinkRbMask::GetFullMask (m_pmc->GetNumRb ());
+  Ptr<MmWaveSidelinkSpectrumPhy> tx = CreateTransmitter (Vector (0.0, 0.0, 0.0), 30.0, rbs);
+
+  std::vector<Transmission> transmissions = {
+    {0, 0, 0, false}, // first transmission, lost
+    {0, 0, 1, true}, // retransmission, combined and decoded
+    {0, 0, 1, false}, // the history has been discarded after the decoding
+    {0, 1, 0, false}, // RV 0, the history is discarded
+    {1, 0, 1, false}, // the history of the other HARQ processes is not used
+    {0, 0, 1, false}, // new NDI, the history is discarded
+    {0, 0, 2, true} // retransmission, combined and decoded
+  };
+  for (uint32_t i = 0; i < transmissions.size (); i++)
+  {
+    Simulator::Schedule (MilliSeconds (i), &MmWaveVehicularHarqCombiningTestCase::Send, this, tx, 2, rbs,
+                         transmissions [i].harqId, transmissions [i].ndi, transmissions [i].rv);
+  }
+  Simulator::Stop (MilliSeconds (transmissions.size () + 1));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_reports.size (), transmissions.size (), "A TB was not received");
+  for (uint32_t i = 0; i < transmissions.size (); i++)
+  {
+    NS_TEST_EXPECT_MSG_EQ (uint16_t (m_reports [i].harqId), uint16_t (transmissions [i].harqId), "Wrong HARQ process ID for TB " << i);
+    NS_TEST_EXPECT_MSG_EQ (m_reports [i].corrupt, !transmissions [i].combined,
+                           "TB " << i << (transmissions [i].combined ? " was not combined" : " was combined with a stale history"));
+  }
+
+  Simulator::Destroy ();
+}
+
 /**
  * Test suite for the class MmWaveSidelinkSpectrumPhy
  */
@@ -235,6 +705,9 @@ MmWaveVehicularSpectrumPhyTestSuite::MmWaveVehicularSpectrumPhyTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new MmWaveVehicularSpectrumPhyTestCase1, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularPartialBandTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularFdmRxTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveVehicularHarqCombiningTestCase, TestCase::QUICK);
 }
 
 static MmWaveVehicularSpectrumPhyTestSuite MmWaveVehicularSpectrumPhyTestSuite;